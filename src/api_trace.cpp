@@ -0,0 +1,107 @@
+/**
+ * @file api_trace.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "api_trace.hpp"
+#include <cstdlib>
+
+namespace majimix::trace {
+
+thread_local int Call::depth = 0;
+
+bool ApiRecorder::open(const std::string &filename)
+{
+	std::lock_guard<std::mutex> lg(mutex);
+	if(os.is_open())
+		os.close();
+	os.open(filename);
+	if(!os)
+		return false;
+	os << "majimix-trace " << trace_version << "\n";
+	active = true;
+	return true;
+}
+
+void ApiRecorder::close(uint64_t block)
+{
+	std::lock_guard<std::mutex> lg(mutex);
+	if(os.is_open())
+	{
+		os << block << " end\n";
+		os.close();
+	}
+	active = false;
+}
+
+void ApiRecorder::write(const std::string &line)
+{
+	std::lock_guard<std::mutex> lg(mutex);
+	if(os.is_open())
+		os << line << '\n' << std::flush;
+}
+
+int Event::int_arg(size_t i) const
+{
+	return i < args.size() ? std::atoi(args[i].c_str()) : 0;
+}
+
+bool Event::bool_arg(size_t i) const
+{
+	return int_arg(i) != 0;
+}
+
+bool load_trace(const std::string &filename, std::vector<Event> &events)
+{
+	std::ifstream is(filename);
+	std::string magic;
+	int version = 0;
+	if(!(is >> magic >> version) || magic != "majimix-trace" || version != trace_version)
+		return false;
+
+	std::string text;
+	std::getline(is, text);
+	while(std::getline(is, text))
+	{
+		std::istringstream line(text);
+		Event event;
+		if(!(line >> event.block >> event.call))
+			continue;
+		std::string arg;
+		while(line >> std::quoted(arg))
+		{
+			if(arg == "=")
+			{
+				event.has_result = static_cast<bool>(line >> event.result);
+				break;
+			}
+			event.args.push_back(arg);
+		}
+		events.push_back(std::move(event));
+	}
+	return true;
+}
+
+}
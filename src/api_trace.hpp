@@ -0,0 +1,166 @@
+/**
+ * @file api_trace.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef API_TRACE_HPP_
+#define API_TRACE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * \namespace majimix::trace
+ * \brief Recording of the Majimix API calls
+ * \details Each state changing call is written to a text file with the index of the
+ *          mixing block it applies to (number of blocks mixed when the call was made).
+ *          A trace can be replayed offline (majimix_replay) to reproduce the exact output.
+ *
+ *          File format - one call per line :
+ *          \code
+ *          majimix-trace 1
+ *          <block> <call> <arguments...> [= <result>]
+ *          <block> end
+ *          \endcode
+ *          String arguments are quoted. Only the outermost call is recorded (set_format
+ *          calling set_mixer_buffer_parameters writes one line).
+ */
+namespace majimix::trace {
+
+constexpr int trace_version = 1;
+
+/**
+ * @brief Trace file writer (thread safe)
+ */
+class ApiRecorder
+{
+	std::mutex mutex;
+	std::ofstream os;
+	std::atomic<bool> active {false};
+
+public:
+	bool open(const std::string &filename);
+	void close(uint64_t block);
+	bool is_active() const { return active.load(std::memory_order_relaxed); }
+	void write(const std::string &line);
+};
+
+/**
+ * @brief One recorded call : the line is written when the call returns
+ *
+ * @code
+ * 	trace::Call call(api_recorder, mixed_blocks, "play_source", source_handle, loop, paused);
+ * 	...
+ * 	return call.result(handle);
+ * @endcode
+ */
+class Call
+{
+	ApiRecorder &recorder;
+	bool recorded;
+	/** only built when the call is recorded */
+	std::optional<std::ostringstream> line;
+
+	static thread_local int depth;
+
+	template<typename T>
+	void put(const T &arg)
+	{
+		*line << ' ';
+		if constexpr (std::is_convertible_v<T, std::string>)
+			*line << std::quoted(std::string(arg));
+		else if constexpr (std::is_same_v<T, bool>)
+			*line << (arg ? 1 : 0);
+		else
+			*line << arg;
+	}
+
+public:
+	template<typename... Args>
+	Call(ApiRecorder &recorder, uint64_t block, const char *name, const Args&... args)
+	: recorder {recorder},
+	  recorded {depth++ == 0 && recorder.is_active()}
+	{
+		if(recorded)
+		{
+			line.emplace();
+			*line << block << ' ' << name;
+			(put(args), ...);
+		}
+	}
+
+	~Call()
+	{
+		--depth;
+		if(recorded)
+			recorder.write(line->str());
+	}
+
+	template<typename T>
+	T result(T value)
+	{
+		if(recorded)
+			*line << " = " << value;
+		return value;
+	}
+
+	Call(const Call &) = delete;
+	Call &operator=(const Call &) = delete;
+};
+
+/**
+ * @brief A call read from a trace file
+ */
+struct Event
+{
+	uint64_t block;
+	std::string call;
+	std::vector<std::string> args;
+	bool has_result = false;
+	long result = 0;
+
+	int int_arg(size_t i) const;
+	bool bool_arg(size_t i) const;
+};
+
+/**
+ * @brief Read a trace file
+ * @param filename the trace
+ * @param[out] events the recorded calls, in order
+ * @return false if the file can't be read or is not a trace
+ */
+bool load_trace(const std::string &filename, std::vector<Event> &events);
+
+}
+
+#endif
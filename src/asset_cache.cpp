@@ -0,0 +1,358 @@
+/**
+ * @file asset_cache.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "asset_cache.hpp"
+#include "wave.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+namespace majimix {
+
+/* ---------------------- Blob ----------------------------- */
+
+Blob::Blob(std::vector<char> &&bytes)
+: bytes {std::move(bytes)},
+  address {this->bytes.data()},
+  length {this->bytes.size()}
+{}
+
+Blob::Blob(std::shared_ptr<const MappedFile> file, uint64_t offset, size_t size)
+: file {std::move(file)},
+  address {this->file->data() + offset},
+  length {size}
+{}
+
+
+/* ---------------------- disk cache ----------------------------- */
+
+/* cache file : the header then the data, in the byte order of the host */
+struct DiskHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t content;
+	uint64_t source_size;
+	int64_t source_date;
+	uint64_t path_hash;
+	uint64_t data_size;
+	/* content_hash of the source file */
+	uint64_t source_hash;
+	/* fnv1a of the fields above : the data is not read to be checked (written aside then renamed) */
+	uint64_t header_hash;
+};
+static_assert(sizeof(DiskHeader) == 64, "DiskHeader layout");
+
+constexpr char disk_magic[8] = {'M', 'J', 'X', 'P', 'C', 'M', '1', 0};
+/* to be changed with the decoding or the conversion of the data */
+constexpr uint32_t disk_version = 3;
+
+static uint64_t fnv1a(const std::string &s, uint64_t h = 0xcbf29ce484222325ULL)
+{
+	for(char c : s)
+		h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+	return h;
+}
+
+/* 64 bits words : 8 bytes per step */
+static uint64_t content_hash(const char *data, size_t size)
+{
+	uint64_t h = 0xcbf29ce484222325ULL ^ size;
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8)
+	{
+		uint64_t w;
+		std::memcpy(&w, data + i, 8);
+		h = (h ^ w) * 0x100000001b3ULL;
+		h ^= h >> 29;
+	}
+	for(; i < size; ++i)
+		h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+	return h;
+}
+
+static uint64_t header_hash(const DiskHeader &header)
+{
+	return fnv1a(std::string(reinterpret_cast<const char *>(&header), offsetof(DiskHeader, header_hash)));
+}
+
+/* only the data computed from the files : the files are read as fast as the cache */
+static bool disk_content(AssetCache::Content content)
+{
+	return wave::little_endian
+	    && (content == AssetCache::Content::vorbis_pcm || content == AssetCache::Content::native_16 || content == AssetCache::Content::native_24);
+}
+
+/* content_hash of a file (mapped) - 0 if it can't be read */
+static uint64_t file_hash(const std::string &filename)
+{
+	MappedFile file;
+	if(!file.open(filename))
+		return 0;
+	return content_hash(file.data(), static_cast<size_t>(file.size()));
+}
+
+AssetCache &AssetCache::instance()
+{
+	static AssetCache cache;
+	return cache;
+}
+
+void AssetCache::purge()
+{
+	for(auto it = files.begin(); it != files.end();)
+		it = it->second.expired() ? files.erase(it) : std::next(it);
+	for(auto it = contents.begin(); it != contents.end();)
+		it = it->second.expired() ? contents.erase(it) : std::next(it);
+}
+
+AssetCache::Data AssetCache::get(const std::string &filename, Content content, const Loader &load)
+{
+	std::error_code ec;
+	Key key {std::filesystem::weakly_canonical(filename, ec).string(), 0, 0, content};
+	if(!ec)
+		key.size = std::filesystem::file_size(filename, ec);
+	if(!ec)
+		key.date = static_cast<int64_t>(std::filesystem::last_write_time(filename, ec).time_since_epoch().count());
+	const bool cached = !ec;
+
+	std::string directory;
+	uint64_t disk_max = 0;
+	if(cached)
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		auto it = files.find(key);
+		if(it != files.end())
+		{
+			if(auto data = it->second.lock())
+			{
+#ifdef DEBUG
+				std::cout << "cache : " << filename << " shared (" << data->size() << " bytes)\n";
+#endif
+				return data;
+			}
+		}
+		if(disk_content(content))
+			directory = disk_directory;
+		disk_max = disk_max_bytes;
+	}
+
+	// computed by a previous run from the same source bytes
+	std::string disk;
+	uint64_t source_hash = 0;
+	if(!directory.empty() && (source_hash = file_hash(filename)) != 0)
+		disk = disk_file(directory, key, source_hash);
+	Data data;
+	if(!disk.empty())
+	{
+		data = disk_load(disk, key, source_hash);
+#ifdef DEBUG
+		if(data)
+			std::cout << "cache : " << filename << " mapped from " << disk << " (" << data->size() << " bytes)\n";
+#endif
+	}
+
+	if(!data)
+	{
+		std::vector<char> loaded;
+		if(!load(loaded))
+			return nullptr;
+		if(!cached)
+			return std::make_shared<const Blob>(std::move(loaded));
+		if(!disk.empty())
+			disk_store(disk, key, disk_max, loaded, source_hash);
+		data = std::make_shared<const Blob>(std::move(loaded));
+	}
+
+	// same content (other path, or loaded concurrently) : the data in use is kept
+	// the data of the disk cache is computed from the source bytes : same source hash, same data
+	const size_t size = data->size();
+	const bool from_source = !disk.empty();
+	const uint64_t hash = from_source ? source_hash : content_hash(data->data(), size);
+	std::lock_guard<std::mutex> lg(mutex);
+	purge();
+	auto &entry = contents[{hash, size, content, from_source}];
+	auto previous = entry.lock();
+	if(previous && (from_source || std::memcmp(previous->data(), data->data(), size) == 0))
+	{
+#ifdef DEBUG
+		std::cout << "cache : " << filename << " same content (" << previous->size() << " bytes)\n";
+#endif
+		data = std::move(previous);
+	}
+	else
+		entry = data;
+	files[key] = data;
+	return data;
+}
+
+AssetCache::Data AssetCache::load(const Loader &load)
+{
+	std::vector<char> loaded;
+	if(!load(loaded))
+		return nullptr;
+	return std::make_shared<const Blob>(std::move(loaded));
+}
+
+bool AssetCache::set_disk_cache(const std::string &directory, uint64_t max_bytes)
+{
+	std::error_code ec;
+	if(!directory.empty())
+		std::filesystem::create_directories(directory, ec);
+	std::lock_guard<std::mutex> lg(mutex);
+	disk_directory = ec ? std::string() : directory;
+	disk_max_bytes = max_bytes;
+	return !ec;
+}
+
+std::string AssetCache::disk_file(const std::string &directory, const Key &key, uint64_t source_hash)
+{
+	if(directory.empty() || !disk_content(key.content))
+		return {};
+	uint64_t h = fnv1a(key.path);
+	h = fnv1a(std::to_string(key.size) + ' ' + std::to_string(key.date) + ' ' + std::to_string(static_cast<int>(key.content))
+	          + ' ' + std::to_string(source_hash), h);
+	std::ostringstream name;
+	name << std::hex << std::setw(16) << std::setfill('0') << h << ".pcm";
+	return (std::filesystem::path(directory) / name.str()).string();
+}
+
+AssetCache::Data AssetCache::disk_load(const std::string &file, const Key &key, uint64_t source_hash)
+{
+	auto mapped = std::make_shared<MappedFile>();
+	if(!mapped->open(file) || mapped->size() < sizeof(DiskHeader))
+		return nullptr;
+
+	// the source was modified or the file belongs to another source (or another version)
+	// the files are written aside then renamed : a damaged header or a truncated file is rejected,
+	// the data itself is not read
+	DiskHeader header;
+	std::memcpy(&header, mapped->data(), sizeof(header));
+	if(std::memcmp(header.magic, disk_magic, sizeof(disk_magic)) || header.version != disk_version
+	   || header.header_hash != header_hash(header)
+	   || header.content != static_cast<uint32_t>(key.content) || header.source_size != key.size
+	   || header.source_date != key.date || header.path_hash != fnv1a(key.path) || header.source_hash != source_hash
+	   || header.data_size != mapped->size() - sizeof(DiskHeader))
+	{
+#ifdef DEBUG
+		std::cout << "cache : " << file << " outdated or damaged\n";
+#endif
+		return nullptr;
+	}
+
+	// recently used
+	std::error_code ec;
+	std::filesystem::last_write_time(file, std::filesystem::file_time_type::clock::now(), ec);
+	return std::make_shared<const Blob>(std::move(mapped), sizeof(DiskHeader), static_cast<size_t>(header.data_size));
+}
+
+void AssetCache::disk_store(const std::string &file, const Key &key, uint64_t max_bytes, const std::vector<char> &data, uint64_t source_hash)
+{
+	const uint64_t file_size = sizeof(DiskHeader) + data.size();
+	if(file_size > max_bytes)
+		return;
+
+	// least recently used files first
+	namespace fs = std::filesystem;
+	std::error_code ec;
+	std::vector<std::tuple<fs::file_time_type, uint64_t, fs::path>> cache_files;
+	uint64_t total = 0;
+	for(auto &entry : fs::directory_iterator(fs::path(file).parent_path(), ec))
+	{
+		std::error_code entry_ec;
+		if(entry.path().extension() != ".pcm" || !entry.is_regular_file(entry_ec))
+			continue;
+		uint64_t size = entry.file_size(entry_ec);
+		auto date = entry.last_write_time(entry_ec);
+		if(entry_ec)
+			continue;
+		cache_files.emplace_back(date, size, entry.path());
+		total += size;
+	}
+	std::sort(cache_files.begin(), cache_files.end());
+	for(auto &[date, size, path] : cache_files)
+	{
+		if(total + file_size <= max_bytes)
+			break;
+		if(fs::remove(path, ec))
+			total -= size;
+	}
+	if(total + file_size > max_bytes)
+		return;
+
+	DiskHeader header {};
+	std::memcpy(header.magic, disk_magic, sizeof(disk_magic));
+	header.version     = disk_version;
+	header.content     = static_cast<uint32_t>(key.content);
+	header.source_size = key.size;
+	header.source_date = key.date;
+	header.path_hash   = fnv1a(key.path);
+	header.data_size   = data.size();
+	header.source_hash = source_hash;
+	header.header_hash = header_hash(header);
+
+	// written aside then renamed : a file is complete or absent (other threads and processes)
+	std::ostringstream temporary;
+	temporary << file << '.' << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+	{
+		std::ofstream out(temporary.str(), std::ios::binary | std::ios::trunc);
+		out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		out.write(data.data(), static_cast<std::streamsize>(data.size()));
+		if(!out)
+		{
+			out.close();
+			fs::remove(temporary.str(), ec);
+			return;
+		}
+	}
+	fs::rename(temporary.str(), file, ec);
+	if(ec)
+		fs::remove(temporary.str(), ec);
+#ifdef DEBUG
+	else
+		std::cout << "cache : " << file << " written (" << data.size() << " bytes)\n";
+#endif
+}
+
+size_t AssetCache::size()
+{
+	std::lock_guard<std::mutex> lg(mutex);
+	size_t bytes = 0;
+	for(auto &[key, entry] : contents)
+		if(auto data = entry.lock())
+			bytes += data->size();
+	return bytes;
+}
+
+}
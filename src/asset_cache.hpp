@@ -0,0 +1,165 @@
+/**
+ * @file asset_cache.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef ASSET_CACHE_HPP_
+#define ASSET_CACHE_HPP_
+
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace majimix {
+
+/**
+ * @class Blob
+ * @brief Immutable bytes : loaded in memory or mapped from a file of the disk cache.
+ */
+class Blob
+{
+	std::vector<char> bytes;
+	std::shared_ptr<const MappedFile> file;
+	const char *address;
+	size_t length;
+
+public:
+	explicit Blob(std::vector<char> &&bytes);
+	/** size bytes at offset in a mapped file */
+	Blob(std::shared_ptr<const MappedFile> file, uint64_t offset, size_t size);
+	Blob(const Blob &) = delete;
+	Blob &operator=(const Blob &) = delete;
+
+	const char *data() const { return address; }
+	size_t size() const { return length; }
+	const char *begin() const { return address; }
+	const char *end() const { return address + length; }
+	/** the bytes are in the page cache (not in the heap) */
+	bool mapped() const { return file != nullptr; }
+};
+
+/**
+ * @class AssetCache
+ * @brief Process wide cache of the sources data.
+ *
+ * The data loaded from a file is immutable : it is shared by all the sources (of all the
+ * mixers) loaded from the same file - same path, size and date - or from a file with the
+ * same content. The cache does not own the data : it is released with its last source.
+ * The decoded and converted data can also be kept on the disk for the next runs (set_disk_cache).
+ */
+class AssetCache
+{
+public:
+	using Data = std::shared_ptr<const Blob>;
+
+	/** what is loaded from the file - the same file gives one entry per content */
+	enum class Content {
+		file,       /**< the whole file (compressed Vorbis played from memory) */
+		wave_data,  /**< the data chunk of a WAVE file */
+		vorbis_pcm, /**< a Vorbis file decoded to int16 */
+		native_16,  /**< WAVE data converted for a 16 bits mixer */
+		native_24   /**< WAVE data converted for a 24 bits mixer */
+	};
+
+	/** load the data - false : load failure, nothing is cached */
+	using Loader = std::function<bool(std::vector<char> &)>;
+
+private:
+	struct Key {
+		std::string path;
+		uint64_t size;
+		int64_t date;
+		Content content;
+		bool operator<(const Key &other) const
+		{
+			return std::tie(path, size, date, content) < std::tie(other.path, other.size, other.date, other.content);
+		}
+	};
+
+	std::mutex mutex;
+	/** file => data */
+	std::map<Key, std::weak_ptr<const Blob>> files;
+	/** hash, size, content, hash of the source file (disk cache) or of the data => data (loaded from any file) */
+	std::map<std::tuple<uint64_t, size_t, Content, bool>, std::weak_ptr<const Blob>> contents;
+
+	/** disk cache of the decoded and converted data - empty : disabled */
+	std::string disk_directory;
+	uint64_t disk_max_bytes = 0;
+
+	AssetCache() = default;
+	/** remove the released entries (mutex held) */
+	void purge();
+	/** cache file of the data computed from the source bytes (source_hash) - empty if the content is not kept on the disk */
+	static std::string disk_file(const std::string &directory, const Key &key, uint64_t source_hash);
+	/** map a cache file (header validated) - nullptr if it is missing, invalid or computed from other source bytes */
+	static Data disk_load(const std::string &file, const Key &key, uint64_t source_hash);
+	/** write a cache file, the least recently used files are removed to fit in max_bytes */
+	static void disk_store(const std::string &file, const Key &key, uint64_t max_bytes, const std::vector<char> &data, uint64_t source_hash);
+
+public:
+	AssetCache(const AssetCache &) = delete;
+	AssetCache &operator=(const AssetCache &) = delete;
+
+	static AssetCache &instance();
+
+	/**
+	 * @brief The data of a file - loaded by load if it is not in use
+	 *
+	 * The file is identified by its canonical path, size and date : a modified file is
+	 * loaded again. The loading is done without lock, a file loaded concurrently by two
+	 * threads is only kept once.
+	 * @return nullptr if load fails
+	 */
+	Data get(const std::string &filename, Content content, const Loader &load);
+
+	/** load data that is not shared (not cached) - nullptr if load fails */
+	static Data load(const Loader &load);
+
+	/**
+	 * @brief Keep the decoded and converted data (vorbis_pcm, native_16, native_24) in a directory
+	 *
+	 * The data computed by a run is written to the directory, the next runs map it instead
+	 * of decoding or converting the file again. The cache files are named after the source
+	 * path and the hash of its bytes, and their header is checked against the source size, date
+	 * and hash before they are used.
+	 * @param directory created if needed - empty : disabled
+	 * @param max_bytes size limit of the directory : the least recently used files are removed
+	 * @return false if the directory can't be created
+	 */
+	bool set_disk_cache(const std::string &directory, uint64_t max_bytes);
+
+	/** bytes of the data in use */
+	size_t size();
+};
+
+}
+
+#endif
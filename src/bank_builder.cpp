@@ -0,0 +1,192 @@
+/**
+ * @file bank_builder.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section bank_builder_desc DESCRIPTION
+ *
+ * majimix_bank_builder : packs WAVE and Vorbis files in a sound bank (Majimix::add_bank).
+ *
+ * The WAVE files are stored as PCM data played from the mapping. With --bits, the float and
+ * 24/32 bits data is converted to the sample type of a 16 bits mixer (int16) or of a 24 bits
+ * mixer (int32) as SourceOptions::pcm_native does at load time. The Vorbis files are stored
+ * compressed, or decoded to int16 PCM if they are shorter than --decode-max-ms.
+ * The assets are named after their file name (without the directory).
+ *
+ * usage : majimix_bank_builder [--bits 16|24] [--decode-max-ms n] bank files...
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "sound_bank.hpp"
+#include "source_pcm.hpp"
+#include "source_vorbis.hpp"
+#include "wave.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace majimix;
+
+namespace {
+
+struct Options {
+	int bits = 0;
+	int decode_max_ms = 0;
+	std::string bank;
+	std::vector<std::string> files;
+};
+
+Options options;
+
+/* the conversion of SourcePCM::convert_to_native (SourceOptions::pcm_native) */
+bool to_native(SoundBank::Asset &asset, AuFormat format)
+{
+	if(!options.bits || !pcm_native_converted(format, options.bits))
+		return false;
+
+	const bool mixer_16 = options.bits == 16;
+	const int native_size = mixer_16 ? 2 : 4;
+	const size_t values = asset.data.size() / asset.channel_size;
+	std::vector<char> converted(values * native_size);
+	pcm_to_native(asset.data.data(), format, asset.channel_size, options.bits, values, converted.data());
+	asset.data = std::move(converted);
+	asset.format = static_cast<uint32_t>(mixer_16 ? AuFormat::int_16bits : AuFormat::int_32bits);
+	asset.channel_size = static_cast<uint16_t>(native_size);
+	return true;
+}
+
+bool load_wave(const std::string &file, SoundBank::Asset &asset)
+{
+	wave::pcm_data pcm;
+	if(!wave::load_wave(file, pcm))
+		return false;
+	AuFormat format = wave_au_format(pcm.fmt);
+	if(format == AuFormat::none || pcm.data_size > static_cast<uint64_t>(INT32_MAX))
+	{
+		std::cerr << file << " : unsupported WAVE format or too long (play it streamed)\n";
+		return false;
+	}
+	asset.kind         = bank::Kind::pcm;
+	asset.format       = static_cast<uint32_t>(format);
+	asset.rate         = pcm.fmt.nSamplesPerSec;
+	asset.channels     = pcm.fmt.nChannels;
+	asset.channel_size = static_cast<uint16_t>(pcm.fmt.nBlockAlign / pcm.fmt.nChannels);
+	asset.loop_start   = pcm.loop_start;
+	asset.loop_end     = pcm.loop_end;
+	asset.data         = std::move(pcm.data);
+	to_native(asset, format);
+	return true;
+}
+
+bool load_vorbis(const std::string &file, SoundBank::Asset &asset)
+{
+	SourceVorbis source;
+	if(!source.set_file(file))
+		return false;
+
+	// short file : decoded once
+	AssetCache::Data pcm;
+	int rate, channels;
+	if(options.decode_max_ms && source.decode_to_pcm(options.decode_max_ms, 0, pcm, rate, channels))
+	{
+		int64_t loop_start, loop_end;
+		asset.kind         = bank::Kind::pcm;
+		asset.format       = static_cast<uint32_t>(AuFormat::int_16bits);
+		asset.rate         = rate;
+		asset.channels     = static_cast<uint16_t>(channels);
+		asset.channel_size = 2;
+		if(source.get_loop_points(loop_start, loop_end))
+		{
+			asset.loop_start = static_cast<uint32_t>(loop_start);
+			asset.loop_end   = static_cast<uint32_t>(loop_end);
+		}
+		asset.data.assign(pcm->begin(), pcm->end());
+		return true;
+	}
+
+	// compressed : the loop points are read from the comments when it is added
+	std::ifstream in(file, std::ios::binary);
+	asset.kind = bank::Kind::vorbis;
+	asset.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	return !asset.data.empty();
+}
+
+void usage()
+{
+	std::cout << "usage : majimix_bank_builder [--bits 16|24] [--decode-max-ms n] bank files...\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--bits" && has_value)
+			options.bits = std::atoi(argv[++i]);
+		else if(arg == "--decode-max-ms" && has_value)
+			options.decode_max_ms = std::max(0, std::atoi(argv[++i]));
+		else if(arg.rfind("--", 0) == 0)
+		{
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+		else if(options.bank.empty())
+			options.bank = arg;
+		else
+			options.files.push_back(arg);
+	}
+	if(options.files.empty() || (options.bits && options.bits != 16 && options.bits != 24))
+	{
+		usage();
+		return 1;
+	}
+
+	std::vector<SoundBank::Asset> assets;
+	for(auto &file : options.files)
+	{
+		SoundBank::Asset asset;
+		asset.name = std::filesystem::path(file).filename().string();
+		// KSS files are emulated : they can't be played from a bank
+		bool loaded = wave::test_wave(file) ? load_wave(file, asset) : load_vorbis(file, asset);
+		if(!loaded)
+		{
+			std::cerr << file << " : not a WAVE or Vorbis file\n";
+			return 1;
+		}
+		std::cout << asset.name << " : " << (asset.kind == bank::Kind::pcm ? "pcm " : "vorbis ") << asset.data.size() << " bytes\n";
+		assets.push_back(std::move(asset));
+	}
+
+	if(!SoundBank::write(options.bank, std::move(assets)))
+	{
+		std::cerr << options.bank << " : write failed (duplicated asset names ?)\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,486 @@
+/**
+ * @file bench.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section bench_desc DESCRIPTION
+ *
+ * majimix_bench : headless micro benchmarks of the mixer hot kernels.
+ *
+ *   - converters (one line per decoder, 16 and 24 bits)
+ *   - SourcePCMF::read (the 4 mono / stereo instantiations and every WAVE format)
+ *   - SampleVorbis::read and voice creation : from the file, in memory or from a decoder pool (--ogg file)
+ *   - CartridgeKSS::read (--kss file)
+ *   - mixing loop (MajimixCore::mix) and encoding (encode_Nbits<2> / <3>)
+ *
+ * Each kernel is measured for several block sizes (frames per call).
+ * Reported values : ns per output frame and GB/s (bytes read + bytes written / time).
+ * For Vorbis and KSS only the output bytes are counted.
+ *
+ * No audio device is used : the tool can run on build servers.
+ *
+ * usage : majimix_bench [--frames n] [--iterations n] [--blocks 64,256,1024,4096] [--ogg file] [--kss file [--track n]] [--filter text]
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench_common.hpp"
+#include "converters.hpp"
+#include "kss.hpp"
+#include "majimix_core.hpp"
+#include "source_adpcm.hpp"
+#include "source_pcm.hpp"
+#include "source_qoa.hpp"
+#include "source_vorbis.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace majimix;
+
+namespace {
+
+struct Options {
+	int frames = 1 << 20;    // frames processed per measure
+	int iterations = 3;      // best of n
+	std::vector<int> blocks {64, 256, 1024, 4096};
+	std::string ogg;
+	std::string kss;
+	int track = 1;
+	std::string filter;
+};
+
+Options options;
+volatile int64_t sink;
+
+bool selected(const std::string &name)
+{
+	return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+/**
+ * Run fn(block) until options.frames frames are processed, keep the best of options.iterations
+ * fn returns the number of bytes read and written for one block
+ */
+template<typename F>
+void measure(const std::string &name, int block, F fn)
+{
+	if(!selected(name))
+		return;
+	int calls = std::max(1, options.frames / block);
+	double best_ns = 0;
+	double bytes = 0;
+	for(int it = 0; it < options.iterations; ++it)
+	{
+		bytes = 0;
+		bench::Stopwatch sw;
+		for(int c = 0; c < calls; ++c)
+			bytes += fn(block);
+		double ns = sw.elapsed_ns();
+		if(it == 0 || ns < best_ns)
+			best_ns = ns;
+	}
+	bench::report(name, block, best_ns, static_cast<double>(calls) * block, bytes);
+}
+
+/* ---------------- converters ---------------- */
+
+struct Converter {
+	const char *name;
+	std::int32_t (*fn)(const char *);
+	int channel_size;
+};
+
+void bench_converters()
+{
+	const Converter table[] = {
+		{"converters::ui8_to_i16",            converters::ui8_to_i16,                   1},
+		{"converters::in_to_i16_le<2>",       converters::in_to_i16_le<2>,              2},
+		{"converters::in_to_i16_le<3>",       converters::in_to_i16_le<3>,              3},
+		{"converters::in_to_i16_le<4>",       converters::in_to_i16_le<4>,              4},
+		{"converters::alaw",                  converters::alaw,                         1},
+		{"converters::ulaw",                  converters::ulaw,                         1},
+		{"converters::float_to_i16<float>",   converters::float_to_i16<float>,          4},
+		{"converters::float_to_i16<double>",  converters::float_to_i16<double>,         8},
+		{"converters::ui8_to_i24",            converters::ui8_to_i24,                   1},
+		{"converters::in_to_i24_le<1>",       converters::in_to_i24_le<1>,              1},
+		{"converters::in_to_i24_le<2>",       converters::in_to_i24_le<2>,              2},
+		{"converters::in_to_i24_le<3>",       converters::in_to_i24_le<3>,              3},
+		{"converters::in_to_i24_le<4>",       converters::in_to_i24_le<4>,              4},
+		{"converters::alaw_i24",              converters::alaw_i24,                     1},
+		{"converters::ulaw_i24",              converters::ulaw_i24,                     1},
+		{"converters::float_to_i24<float>",   converters::float_to_i24<float>,          4},
+		{"converters::float_to_i24<double>",  converters::float_to_i24<double>,         8},
+	};
+
+	for(auto &c : table)
+	{
+		for(int block : options.blocks)
+		{
+			// stereo input - plausible values for the float decoders
+			const int values = block * 2;
+			std::vector<char> in(static_cast<size_t>(values) * c.channel_size);
+			for(int i = 0; i < values; ++i)
+			{
+				char *p = in.data() + static_cast<size_t>(i) * c.channel_size;
+				if(c.channel_size == 4 && std::strstr(c.name, "float"))
+				{
+					float f = static_cast<float>((i % 200) - 100) / 128.f;
+					std::memcpy(p, &f, sizeof f);
+				}
+				else if(c.channel_size == 8)
+				{
+					double d = static_cast<double>((i % 200) - 100) / 128.;
+					std::memcpy(p, &d, sizeof d);
+				}
+				else
+					for(int b = 0; b < c.channel_size; ++b)
+						p[b] = static_cast<char>(i * 31 + b * 7);
+			}
+			std::vector<int32_t> out(values);
+
+			measure(c.name, block, [&](int) {
+				const char *p = in.data();
+				for(int i = 0; i < values; ++i, p += c.channel_size)
+					out[i] = c.fn(p);
+				sink = sink + out[values - 1];
+				return static_cast<double>(in.size() + out.size() * sizeof(int32_t));
+			});
+		}
+	}
+}
+
+/* ---------------- PCM sources ---------------- */
+
+struct WaveAsset {
+	std::string name;
+	uint16_t format_tag;
+	int bits;
+	int channels;
+};
+
+void bench_source(const std::string &name, Source &source, double source_sample_size, double source_rate, int mixer_rate, int mixer_channels)
+{
+	auto sample = source.create_sample();
+	for(int block : options.blocks)
+	{
+		std::vector<int32_t> out(static_cast<size_t>(block) * mixer_channels);
+		const double in_bytes = static_cast<double>(block) * source_rate / mixer_rate * source_sample_size;
+		const double out_bytes = static_cast<double>(out.size()) * sizeof(int32_t);
+		measure(name, block, [&](int n) {
+			sample->read(out.data(), n);
+			sink = sink + out[0];
+			return in_bytes + out_bytes;
+		});
+	}
+}
+
+void bench_pcm(const std::string &dir)
+{
+	constexpr int source_rate = 22050;
+	constexpr int mixer_rate = 44100;
+	constexpr int frames = source_rate * 4;
+
+	const WaveAsset assets[] = {
+		{"s16-mono",    bench::wave_pcm,   16, 1},
+		{"s16-stereo",  bench::wave_pcm,   16, 2},
+		{"u8-stereo",   bench::wave_pcm,    8, 2},
+		{"s24-stereo",  bench::wave_pcm,   24, 2},
+		{"s32-stereo",  bench::wave_pcm,   32, 2},
+		{"f32-stereo",  bench::wave_float, 32, 2},
+		{"f64-stereo",  bench::wave_float, 64, 2},
+		{"alaw-stereo", bench::wave_alaw,   8, 2},
+		{"ulaw-stereo", bench::wave_ulaw,   8, 2},
+	};
+
+	for(auto &a : assets)
+	{
+		std::string filename = dir + "/" + a.name + ".wav";
+		if(!bench::write_wave(filename, a.format_tag, a.bits, a.channels, source_rate, frames))
+		{
+			std::cerr << "cannot write " << filename << "\n";
+			continue;
+		}
+
+		SourcePCMF source;
+		if(!source.load_wave(filename))
+		{
+			std::cerr << "cannot load " << filename << "\n";
+			continue;
+		}
+		const int sample_size = a.bits / 8 * a.channels;
+
+		// SourcePCMF::read<STEREO_INPUT, STEREO_OUTPUT> : every instantiation for s16, stereo output for the other formats
+		const bool s16 = a.format_tag == bench::wave_pcm && a.bits == 16;
+		for(int mixer_channels = s16 ? 1 : 2; mixer_channels <= 2; ++mixer_channels)
+		{
+			for(int mixer_bits : {16, 24})
+			{
+				std::ostringstream name;
+				name << "SourcePCMF::read<" << (a.channels == 2) << "," << (mixer_channels == 2) << "> " << a.name << " i" << mixer_bits;
+				source.set_output_format(mixer_rate, mixer_channels, mixer_bits);
+				bench_source(name.str(), source, sample_size, source_rate, mixer_rate, mixer_channels);
+			}
+		}
+	}
+}
+
+/* ---------------- ADPCM and QOA ---------------- */
+
+void bench_block(const std::string &dir)
+{
+	constexpr int source_rate = 22050;
+	constexpr int mixer_rate = 44100;
+	constexpr int frames = source_rate * 4;
+
+	for(int channels : {1, 2})
+	{
+		const std::string suffix = channels == 2 ? "-stereo" : "-mono";
+		const std::string ima = dir + "/ima" + suffix + ".wav";
+		const std::string qoa = dir + "/qoa" + suffix + ".qoa";
+		SourceADPCM source_ima;
+		SourceQOA source_qoa;
+		if(!bench::write_wave(ima, bench::wave_ima, 4, channels, source_rate, frames) || !source_ima.load_wave(ima)
+		   || !bench::write_qoa(qoa, channels, source_rate, frames) || !source_qoa.load(qoa))
+		{
+			std::cerr << "cannot load " << ima << " / " << qoa << "\n";
+			continue;
+		}
+		// block decoding and resampling
+		const struct {
+			const char *name;
+			SourceBlock *source;
+			double bits;
+		} sources[] = {{"ima", &source_ima, 4.}, {"qoa", &source_qoa, 3.2}};
+		for(auto &[name, source, bits] : sources)
+		{
+			for(int mixer_bits : {16, 24})
+			{
+				std::ostringstream kernel;
+				kernel << "SampleBlock::read<" << (channels == 2) << ",1> " << name << suffix << " i" << mixer_bits;
+				source->set_output_format(mixer_rate, 2, mixer_bits);
+				bench_source(kernel.str(), *source, bits / 8 * channels, source_rate, mixer_rate, 2);
+			}
+		}
+	}
+}
+
+/* ---------------- Vorbis ---------------- */
+
+void bench_vorbis()
+{
+	for(bool in_memory : {false, true})
+	{
+		SourceVorbis source;
+		if(!source.set_file(options.ogg, in_memory))
+		{
+			std::cerr << "cannot load " << options.ogg << "\n";
+			return;
+		}
+		const std::string storage = in_memory ? " memory" : "";
+		for(int mixer_bits : {16, 24})
+		{
+			source.set_output_format(44100, 2, mixer_bits);
+			bench_source("SampleVorbis::read i" + std::to_string(mixer_bits) + storage, source, 0, 0, 44100, 2);
+		}
+
+		// voice start latency (file open and headers parsing)
+		const std::string name = std::string("SourceVorbis::create_sample ") + (in_memory ? "memory" : "file");
+		if(selected(name))
+		{
+			constexpr int count = 64;
+			bench::Stopwatch sw;
+			for(int i = 0; i < count; ++i)
+				sink = sink + (source.create_sample() != nullptr);
+			std::printf("%-44s %10.1f us/voice\n", name.c_str(), sw.elapsed_ns() / count / 1000.);
+		}
+	}
+
+	// voice start from a pool of opened decoders (rewound when recycled)
+	const std::string name = "SourceVorbis::create_sample pool";
+	SourceVorbis source;
+	if(selected(name) && source.set_file(options.ogg))
+	{
+		source.set_decoder_pool_size(1);
+		source.set_output_format(44100, 2, 16);
+		constexpr int count = 64;
+		bench::Stopwatch sw;
+		for(int i = 0; i < count; ++i)
+			source.recycle_sample(source.create_sample());
+		std::printf("%-44s %10.1f us/voice\n", name.c_str(), sw.elapsed_ns() / count / 1000.);
+	}
+}
+
+/* ---------------- KSS ---------------- */
+
+void bench_kss()
+{
+	for(int mixer_bits : {16, 24})
+	{
+		KSS *kss = kss::load_kss(options.kss);
+		if(!kss)
+		{
+			std::cerr << "cannot load " << options.kss << "\n";
+			return;
+		}
+		kss::CartridgeKSS cartridge(kss, 1, 44100, 2, mixer_bits);
+		if(!cartridge.active_line(options.track, false))
+		{
+			std::cerr << "cannot play track " << options.track << "\n";
+			return;
+		}
+		const std::string name = "CartridgeKSS::read i" + std::to_string(mixer_bits);
+		for(int block : options.blocks)
+		{
+			std::vector<int> out(static_cast<size_t>(block) * 2);
+			measure(name, block, [&](int n) {
+				std::fill(out.begin(), out.end(), 0);
+				cartridge.read(out.begin(), n);
+				sink = sink + out[0];
+				return static_cast<double>(out.size() * sizeof(int));
+			});
+		}
+	}
+}
+
+/* ---------------- mix and encode ---------------- */
+
+void bench_mix(const std::string &dir)
+{
+	const std::string filename = dir + "/mix-s16-stereo.wav";
+	if(!bench::write_wave(filename, bench::wave_pcm, 16, 2, 22050, 22050 * 4))
+		return;
+
+	for(int mixer_bits : {16, 24})
+	{
+		for(int voices : {1, 8, 32})
+		{
+			for(int block : options.blocks)
+			{
+				MajimixOffline mixer;
+				if(!mixer.set_format(44100, true, mixer_bits, voices) || !mixer.set_mixer_buffer_parameters(2, block))
+					continue;
+				int source = mixer.add_source(filename);
+				for(int v = 0; v < voices; ++v)
+					mixer.play_source(source, true);
+
+				std::vector<char> out;
+				mixer.render(out);
+				const double bytes = static_cast<double>(block) * 2 * voices * sizeof(int32_t) + out.size();
+				measure("MajimixCore::mix " + std::to_string(voices) + " voices i" + std::to_string(mixer_bits), block, [&](int) {
+					mixer.render(out);
+					sink = sink + out[0];
+					return bytes;
+				});
+
+				// encode the last mixed block again
+				const double encode_bytes = static_cast<double>(block) * 2 * sizeof(int32_t) + out.size();
+				if(voices == 1)
+				{
+					if(mixer_bits == 16)
+						measure("MajimixCore::encode_Nbits<2>", block, [&](int) {
+							mixer.encode_Nbits<2>(out.begin());
+							sink = sink + out[0];
+							return encode_bytes;
+						});
+					else
+						measure("MajimixCore::encode_Nbits<3>", block, [&](int) {
+							mixer.encode_Nbits<3>(out.begin());
+							sink = sink + out[0];
+							return encode_bytes;
+						});
+				}
+			}
+		}
+	}
+}
+
+std::vector<int> parse_blocks(const std::string &s)
+{
+	std::vector<int> blocks;
+	std::istringstream is(s);
+	std::string item;
+	while(std::getline(is, item, ','))
+	{
+		int b = std::atoi(item.c_str());
+		if(b > 0)
+			blocks.push_back(b);
+	}
+	return blocks;
+}
+
+void usage()
+{
+	std::cout << "usage : majimix_bench [--frames n] [--iterations n] [--blocks 64,256,1024,4096]\n"
+	             "                      [--ogg file] [--kss file [--track n]] [--filter text]\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--frames" && has_value)
+			options.frames = std::max(1, std::atoi(argv[++i]));
+		else if(arg == "--iterations" && has_value)
+			options.iterations = std::max(1, std::atoi(argv[++i]));
+		else if(arg == "--blocks" && has_value)
+			options.blocks = parse_blocks(argv[++i]);
+		else if(arg == "--ogg" && has_value)
+			options.ogg = argv[++i];
+		else if(arg == "--kss" && has_value)
+			options.kss = argv[++i];
+		else if(arg == "--track" && has_value)
+			options.track = std::atoi(argv[++i]);
+		else if(arg == "--filter" && has_value)
+			options.filter = argv[++i];
+		else
+		{
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+	if(options.blocks.empty())
+	{
+		usage();
+		return 1;
+	}
+
+	const std::string dir = bench::temp_directory("majimix_bench");
+
+	bench::report_header();
+	bench_converters();
+	bench_pcm(dir);
+	bench_block(dir);
+	if(!options.ogg.empty())
+		bench_vorbis();
+	if(!options.kss.empty())
+		bench_kss();
+	bench_mix(dir);
+
+	return 0;
+}
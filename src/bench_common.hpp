@@ -0,0 +1,303 @@
+/**
+ * @file bench_common.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * Helpers shared by the headless benchmark tools : test WAVE files generation,
+ * timing and report formatting.
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef BENCH_COMMON_HPP_
+#define BENCH_COMMON_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace majimix::bench {
+
+/* WAVE format tags */
+constexpr uint16_t wave_pcm   = 0x0001;
+constexpr uint16_t wave_ms    = 0x0002;
+constexpr uint16_t wave_float = 0x0003;
+constexpr uint16_t wave_alaw  = 0x0006;
+constexpr uint16_t wave_ulaw  = 0x0007;
+constexpr uint16_t wave_ima   = 0x0011;
+
+template <typename T>
+inline void put_le(std::ofstream &os, T v, int bytes = sizeof(T))
+{
+	for(int i = 0; i < bytes; ++i)
+		os.put(static_cast<char>((static_cast<uint64_t>(v) >> (8 * i)) & 0xFF));
+}
+
+/**
+ * @brief Write a WAVE file containing a 440 Hz sine (or a byte pattern for a-law / µ-law / ADPCM)
+ *
+ * @param filename output file
+ * @param format_tag wave_pcm, wave_float, wave_alaw, wave_ulaw, wave_ima or wave_ms
+ * @param bits bits per sample (8 16 24 32 for pcm, 32 64 for float, 8 for a-law and µ-law, 4 for ADPCM)
+ * @param channels 1 or 2
+ * @param rate sample rate
+ * @param frames number of samples (per channel)
+ * @return true if the file was written
+ */
+inline bool write_wave(const std::string &filename, uint16_t format_tag, int bits, int channels, int rate, int frames)
+{
+	std::ofstream os(filename, std::ios::binary);
+	if(!os)
+		return false;
+
+	if(format_tag == wave_ima || format_tag == wave_ms)
+	{
+		// blocks of 256 bytes per channel
+		//  IMA : 4 bytes header and 252 bytes of nibbles per channel (505 frames)
+		//  MS  : 7 bytes header per channel (predictor, delta, 2 samples) and nibbles (500 frames)
+		const bool ms = format_tag == wave_ms;
+		const uint32_t block_align = 256 * channels;
+		const uint32_t block_frames = ms ? 500 : 505;
+		const uint32_t block_count = (frames + block_frames - 1) / block_frames;
+		const uint32_t data_size = block_align * block_count;
+		const uint16_t extension_size = ms ? 4 + 7 * 4 : 2;
+
+		os.write("RIFF", 4);
+		put_le<uint32_t>(os, 4 + 8 + 18 + extension_size + 8 + data_size);
+		os.write("WAVEfmt ", 8);
+		put_le<uint32_t>(os, 18 + extension_size);
+		put_le<uint16_t>(os, format_tag);
+		put_le<uint16_t>(os, channels);
+		put_le<uint32_t>(os, rate);
+		put_le<uint32_t>(os, rate * block_align / block_frames);
+		put_le<uint16_t>(os, block_align);
+		put_le<uint16_t>(os, bits);
+		put_le<uint16_t>(os, extension_size);
+		put_le<uint16_t>(os, block_frames);
+		if(ms)
+		{
+			// the standard coefficients
+			const int16_t coefficients[14] = {256, 0, 512, -256, 0, 0, 192, 64, 240, 0, 460, -208, 392, -232};
+			put_le<uint16_t>(os, 7);
+			for(int16_t c : coefficients)
+				put_le<uint16_t>(os, static_cast<uint16_t>(c));
+		}
+		os.write("data", 4);
+		put_le<uint32_t>(os, data_size);
+		for(uint32_t b = 0; b < block_count; ++b)
+		{
+			uint32_t i = 0;
+			if(ms)
+			{
+				// predictor (cycling through the coefficients), delta 16, samples 0
+				for(int c = 0; c < channels; ++c, ++i)
+					put_le<uint8_t>(os, static_cast<uint8_t>((b + c) % 7));
+				for(int c = 0; c < channels; ++c, i += 6)
+				{
+					put_le<uint16_t>(os, 16);
+					put_le<uint32_t>(os, 0);
+				}
+			}
+			for(; i < block_align; ++i)
+				put_le<uint8_t>(os, static_cast<uint8_t>((b * block_align + i) * 37));
+		}
+		return static_cast<bool>(os);
+	}
+
+	const int channel_size = bits / 8;
+	const uint32_t block_align = channel_size * channels;
+	const uint32_t data_size = block_align * frames;
+
+	os.write("RIFF", 4);
+	put_le<uint32_t>(os, 4 + 8 + 16 + 8 + data_size + (data_size & 1));
+	os.write("WAVEfmt ", 8);
+	put_le<uint32_t>(os, 16);
+	put_le<uint16_t>(os, format_tag);
+	put_le<uint16_t>(os, channels);
+	put_le<uint32_t>(os, rate);
+	put_le<uint32_t>(os, rate * block_align);
+	put_le<uint16_t>(os, block_align);
+	put_le<uint16_t>(os, bits);
+	os.write("data", 4);
+	put_le<uint32_t>(os, data_size);
+
+	const double w = 2. * M_PI * 440. / rate;
+	for(int i = 0; i < frames; ++i)
+	{
+		double v = 0.5 * std::sin(w * i);
+		for(int c = 0; c < channels; ++c)
+		{
+			if(format_tag == wave_float)
+			{
+				if(bits == 32)
+				{
+					float f = static_cast<float>(v);
+					os.write(reinterpret_cast<const char *>(&f), sizeof f);
+				}
+				else
+					os.write(reinterpret_cast<const char *>(&v), sizeof v);
+			}
+			else if(format_tag == wave_pcm)
+			{
+				if(bits == 8)
+					put_le<uint8_t>(os, static_cast<uint8_t>(128 + v * 127));
+				else
+					put_le<int64_t>(os, static_cast<int64_t>(v * ((int64_t{1} << (bits - 1)) - 1)), channel_size);
+			}
+			else
+				put_le<uint8_t>(os, static_cast<uint8_t>(i * 37 + c));
+		}
+	}
+	if(data_size & 1)
+		os.put(0);
+	return static_cast<bool>(os);
+}
+
+/**
+ * @brief Write a QOA file containing a byte pattern (valid frames and slices)
+ *
+ * @param filename output file
+ * @param channels 1 to 8
+ * @param rate sample rate
+ * @param frames number of samples (per channel)
+ * @return true if the file was written
+ */
+inline bool write_qoa(const std::string &filename, int channels, int rate, int frames)
+{
+	std::ofstream os(filename, std::ios::binary);
+	if(!os)
+		return false;
+
+	auto put_be = [&os](uint64_t v, int bytes) {
+		for(int i = bytes - 1; i >= 0; --i)
+			os.put(static_cast<char>((v >> (8 * i)) & 0xFF));
+	};
+	os.write("qoaf", 4);
+	put_be(frames, 4);
+	uint32_t pattern = 0;
+	for(int start = 0; start < frames; start += 5120)
+	{
+		const int frame_len = std::min(frames - start, 5120);
+		const int slices = (frame_len + 19) / 20;
+		put_be(channels, 1);
+		put_be(rate, 3);
+		put_be(frame_len, 2);
+		put_be(8 + 16 * channels + 8 * slices * channels, 2);
+		// LMS state : no history, weights {0, 0, -1, 2} (x 8192)
+		for(int c = 0; c < channels; ++c)
+		{
+			put_be(0, 8);
+			put_be(0xE0004000, 8);
+		}
+		for(int i = 0; i < slices * channels * 8; ++i)
+			put_be(++pattern * 37, 1);
+	}
+	return static_cast<bool>(os);
+}
+
+/**
+ * @brief Write a KSS file (KSCC, MSX) whose init routine plays a tone on the PSG channel A
+ *
+ * @param filename output file
+ * @return true if the file was written
+ */
+inline bool write_kss(const std::string &filename)
+{
+	std::ofstream os(filename, std::ios::binary);
+	if(!os)
+		return false;
+
+	// init : PSG registers 7 (mixer : tone A), 0 and 1 (period), 8 (volume A) - ld a,r / out (a0h),a / ld a,v / out (a1h),a
+	// play : ret
+	std::vector<uint8_t> code;
+	const uint8_t registers[][2] = {{7, 0x3E}, {0, 0xFE}, {1, 0x00}, {8, 0x0F}};
+	for(auto &r : registers)
+		code.insert(code.end(), {0x3E, r[0], 0xD3, 0xA0, 0x3E, r[1], 0xD3, 0xA1});
+	code.push_back(0xC9);
+	const uint16_t load = 0x4000;
+	const uint16_t play = static_cast<uint16_t>(load + code.size());
+	code.push_back(0xC9);
+
+	os.write("KSCC", 4);
+	put_le<uint16_t>(os, load);
+	put_le<uint16_t>(os, static_cast<uint16_t>(code.size()));
+	put_le<uint16_t>(os, load);
+	put_le<uint16_t>(os, play);
+	// start bank, bank count, extra header size, device flags (PSG and SCC)
+	put_le<uint32_t>(os, 0);
+	os.write(reinterpret_cast<const char *>(code.data()), static_cast<std::streamsize>(code.size()));
+	return static_cast<bool>(os);
+}
+
+/**
+ * @brief Directory used for the generated assets (created if needed)
+ */
+inline std::string temp_directory(const std::string &name)
+{
+	std::filesystem::path p = std::filesystem::temp_directory_path() / name;
+	std::filesystem::create_directories(p);
+	return p.string();
+}
+
+/**
+ * @brief Monotonic stopwatch
+ */
+class Stopwatch
+{
+	std::chrono::steady_clock::time_point start_time;
+
+public:
+	Stopwatch() : start_time{std::chrono::steady_clock::now()} {}
+	void restart() { start_time = std::chrono::steady_clock::now(); }
+	double elapsed_ns() const
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+	}
+};
+
+/**
+ * @brief Print a report line
+ * @param name kernel name
+ * @param block block size (frames)
+ * @param total_ns measured time
+ * @param frames number of frames processed
+ * @param bytes number of bytes read and written
+ */
+inline void report(const std::string &name, int block, double total_ns, double frames, double bytes)
+{
+	std::printf("%-40s %6d %12.3f %10.3f\n", name.c_str(), block, total_ns / frames, bytes / total_ns);
+}
+
+inline void report_header()
+{
+	std::printf("%-40s %6s %12s %10s\n", "kernel", "block", "ns/frame", "GB/s");
+}
+
+}
+
+#endif
@@ -29,6 +29,8 @@
 #ifndef CONVERTERS_INL_
 #define CONVERTERS_INL_
 
+#include <cstring>
+
 namespace majimix::converters {
 
 /* ---------- decoders i16 ---------- */
@@ -42,7 +44,9 @@ std::int32_t in_to_i16_le(const char *data)
 template <typename FLOAT_TYPE>
 std::int32_t float_to_i16(const char *data)
 {
-	FLOAT_TYPE v = *reinterpret_cast<const FLOAT_TYPE *>(data);
+	// data can be unaligned (mapped file)
+	FLOAT_TYPE v;
+	std::memcpy(&v, data, sizeof v);
 	return v * 0x7FFF;
 }
 
@@ -58,7 +62,8 @@ std::int32_t in_to_i24_le(const char *data)
 template <typename FLOAT_TYPE>
 std::int32_t float_to_i24(const char *data)
 {
-	FLOAT_TYPE v = *(reinterpret_cast<const FLOAT_TYPE *>(data));
+	FLOAT_TYPE v;
+	std::memcpy(&v, data, sizeof v);
 	return v * 0x7FFFFF;
 }
 }
@@ -78,9 +78,37 @@ public:
 
     /**
      * @brief Create a new Sample from this Source.
+     * @param loop the Sample is played in a loop - known before the Sample reads ahead
      * @return
      */
-    virtual std::unique_ptr<Sample> create_sample() = 0;
+    virtual std::unique_ptr<Sample> create_sample(bool loop = false) = 0;
+
+    /**
+     * @brief The Source keeps the Samples given back (recycle_sample) : the mixer returns the
+     *        Samples of the stopped voices as soon as it collects them.
+     */
+    virtual bool recycles_samples() const { return false; }
+
+    /**
+     * @brief Give back a Sample created by this Source that the mixer no longer uses.
+     *        The Source can keep it for a next create_sample (by default it is destroyed).
+     * @param sample
+     */
+    virtual void recycle_sample(std::unique_ptr<Sample> sample) {}
+
+    /**
+     * @brief Loop points (samples) : a looping Sample plays [0, end) then repeats [start, end).
+     * @param start first sample of the loop
+     * @param end end of the loop (excluded)
+     * @return false if the source has no loop points (the whole source is repeated)
+     */
+    virtual bool get_loop_points(int64_t &start, int64_t &end) const { return false; }
+
+    /**
+     * @brief Memory held by the Source (bytes) - released when the Source is evicted from the
+     *        mixer memory budget. The mapped files and the Samples buffers are not counted.
+     */
+    virtual size_t memory_size() const { return 0; }
 };
 
 /**
@@ -124,6 +152,14 @@ public:
      * @param pos time location in seconds
      */
     virtual void seek_time(double pos) = 0;
+
+    /**
+     * @brief The mixer plays this Sample in a loop.
+     *        A Sample that supports it joins its end and its beginning in the same read
+     *        (no partial read at the end). By default the mixer calls read again.
+     * @param loop
+     */
+    virtual void set_loop(bool loop) {}
 };
 }
 #endif
\ No newline at end of file
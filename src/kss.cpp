@@ -28,6 +28,7 @@
  */
 
 #include "kss.hpp"
+#include "profiler.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -241,6 +242,14 @@ bool CartridgeKSS::set_output_format(int samples_per_sec, int channels, int bits
 	return false;
 }
 
+void CartridgeKSS::reserve(int max_sample_count)
+{
+	// stereo size : the output format can change
+	const size_t data_count = static_cast<size_t>(max_sample_count) * 2;
+	if (m_lines_buffer.size() < data_count)
+		m_lines_buffer.resize(data_count);
+}
+
 bool CartridgeKSS::set_lines_count(int nb_lines)
 {
 	if (nb_lines > 0)
@@ -293,7 +302,10 @@ int CartridgeKSS::read_line_convert(std::vector<int>::iterator it_out, KSSLine &
 			}
 
 			// retrieves data
-			KSSPLAY_calc(line.kssplay_ptr.get(), m_lines_buffer.data(), requested_sample_count);
+			{
+				MAJIMIX_PROFILE_SCOPE_VOICE(kss_emulation, line.id);
+				KSSPLAY_calc(line.kssplay_ptr.get(), m_lines_buffer.data(), requested_sample_count);
+			}
 
 			// check autostop
 			deactivate = line.autostop && (KSSPLAY_get_stop_flag(line.kssplay_ptr.get()) == 1);
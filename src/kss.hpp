@@ -179,6 +179,13 @@ public:
 	CartridgeKSS(KSS* kss, int nb_lines = 1, int rate = 44100, int channels = 2, int bits = 16, int silent_limit_ms = 500);
 	bool set_output_format(int samples_per_sec, int channels, int bits/*, int silent_limit_ms*/);
 	bool set_lines_count(int nb_lines);
+
+	/**
+	 * @brief Allocate the internal buffer for reads of up to max_sample_count samples
+	 *        (otherwise the buffer is resized by the first read - on the mixing thread).
+	 */
+	void reserve(int max_sample_count);
+
 	int get_line_count() const;
 	int read(std::vector<int>::iterator it_out,  int requested_sample_count);
 
@@ -0,0 +1,96 @@
+/**
+ * @file load_pool.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "load_pool.hpp"
+#include <algorithm>
+
+namespace majimix {
+
+static thread_local bool worker_thread = false;
+
+LoadPool &LoadPool::instance()
+{
+	static LoadPool pool;
+	return pool;
+}
+
+LoadPool::~LoadPool()
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		running = false;
+		// not started tasks are dropped
+		tasks.clear();
+	}
+	cv.notify_all();
+	for(auto &w : workers)
+		w.join();
+}
+
+void LoadPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		tasks.push_back(std::move(task));
+		if(!running)
+		{
+			running = true;
+			unsigned int count = std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+			for(unsigned int i = 0; i < count; ++i)
+				workers.emplace_back(&LoadPool::run, this);
+		}
+	}
+	cv.notify_one();
+}
+
+bool LoadPool::is_worker()
+{
+	return worker_thread;
+}
+
+void LoadPool::run()
+{
+	worker_thread = true;
+	std::unique_lock<std::mutex> lock(mutex);
+	while(running)
+	{
+		if(tasks.empty())
+		{
+			cv.wait(lock);
+			continue;
+		}
+		auto task = std::move(tasks.front());
+		tasks.pop_front();
+		lock.unlock();
+		task();
+		// released without lock (the result of an abandoned task)
+		task = nullptr;
+		lock.lock();
+	}
+}
+
+}
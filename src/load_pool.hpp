@@ -0,0 +1,74 @@
+/**
+ * @file load_pool.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef LOAD_POOL_HPP_
+#define LOAD_POOL_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace majimix {
+
+/**
+ * @class LoadPool
+ * @brief Shared pool of loading threads (Majimix::add_source_async).
+ *
+ * The tasks are run in submission order, independent files are loaded in parallel.
+ * The threads are started with the first task.
+ */
+class LoadPool
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::deque<std::function<void()>> tasks;
+	std::vector<std::thread> workers;
+	bool running = false;
+
+	LoadPool() = default;
+	void run();
+
+public:
+	~LoadPool();
+	LoadPool(const LoadPool &) = delete;
+	LoadPool &operator=(const LoadPool &) = delete;
+
+	static LoadPool &instance();
+
+	/** run task on a worker thread */
+	void submit(std::function<void()> task);
+
+	/** true on a worker thread : the tasks do not start threads of their own (the pool bounds them) */
+	static bool is_worker();
+};
+
+}
+
+#endif
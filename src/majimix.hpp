@@ -52,6 +52,7 @@
  * Majimix supports the following audio formats (mono or stereo only)
  *   - WAVE
  *   - Ogg
+ *   - QOA
  *   - KSS
  * 
  * 
@@ -126,7 +127,9 @@
 #define MAJIMIX_PA_HPP_
 
 #include <string>
+#include <map>
 #include <memory>
+#include <vector>
 
 
 #ifdef _WIN32
@@ -159,6 +162,112 @@ constexpr int MixerStopped =  0;
 constexpr int MixerPaused  =  1;
 constexpr int MixerRunning =  2;
 
+/* source status (Majimix::get_source_status) */
+constexpr int SourceFailed   = -1;
+constexpr int SourceInvalid  =  0;
+constexpr int SourceLoading  =  1;
+constexpr int SourceReady    =  2;
+constexpr int SourceUnloaded =  3;
+
+
+/**
+ * @brief Loading options of a source
+ * @see Majimix::add_source
+ */
+struct SourceOptions {
+	/**
+	 * Vorbis only : the compressed file is loaded in memory once and shared by all the
+	 * samples (voices) of the source. Playing the source no longer opens the file.
+	 */
+	bool vorbis_in_memory = false;
+
+	/**
+	 * Vorbis only : number of decoders opened in advance and kept ready to play.
+	 * Playing the source takes a decoder from this pool (no file opening nor decoder
+	 * initialization on the calling thread). The decoder of a stopped sample goes back to the
+	 * pool when the stopped samples are collected, by the next play_source or stop_playback call,
+	 * and its seek back to the beginning is left to the decoding threads. If they have not prepared it yet,
+	 * play_source decodes its first blocks on the calling thread.
+	 */
+	int vorbis_decoders = 0;
+
+	/**
+	 * Vorbis only : a file shorter than this duration (milliseconds) is fully decoded when the
+	 * source is added and played from memory as PCM data, like a WAVE file. 0 : disabled.
+	 */
+	int vorbis_decode_max_ms = 0;
+
+	/**
+	 * Vorbis only : a file whose decoded size (16 bits PCM) is lower than this size (bytes) is
+	 * fully decoded when the source is added. 0 : disabled.
+	 */
+	int vorbis_decode_max_bytes = 0;
+
+	/**
+	 * Vorbis only : an index of the Ogg pages (position => file offset) is built in the
+	 * background when the source is added. Seeking (a sample played again, ...) then jumps
+	 * to the right page instead of searching it in the file.
+	 */
+	bool vorbis_seek_index = false;
+
+	/**
+	 * Vorbis only, with vorbis_seek_index : the index is saved next to the file (<file>.idx)
+	 * and loaded instead of being rebuilt the next time, as long as the file is unchanged.
+	 */
+	bool vorbis_seek_index_file = false;
+
+	/**
+	 * Vorbis only : the first milliseconds of the file (e.g. 250) are decoded when the source
+	 * is added and kept in memory. A looping sample then restarts from memory while its decoder
+	 * seeks in the background, as does a sample played again. 0 : disabled.
+	 */
+	int vorbis_loop_head_ms = 0;
+
+	/**
+	 * WAVE only : the file is mapped in memory instead of being read. Adding the source only
+	 * reads the headers, the data is loaded by the system when it is played and its pages are
+	 * shared with the file cache (and the other processes playing the file).
+	 */
+	bool wave_mapped = false;
+
+	/**
+	 * WAVE only : the file is played from the disk, read ahead in a small buffer by each
+	 * sample (voice). The memory used does not depend on the duration (ambiences, voice-overs).
+	 * The files too large to be loaded in memory (RF64 and Wave64 over 2 GB) are always streamed.
+	 * The IMA / MS ADPCM files are never streamed : they are kept compressed in memory (or mapped)
+	 * and each voice decodes the blocks it plays.
+	 */
+	bool wave_streamed = false;
+
+	/**
+	 * WAVE only : the samples are converted once, when the mixer is configured, to the mixer
+	 * format (16 bits or 24 bits in 32) instead of being decoded at each read. Float and 24/32
+	 * bits files use less memory with a 16 bits mixer, the 8 bits and A-law / mu-law files are
+	 * kept as is and decoded with a table. Not applied to mapped files.
+	 */
+	bool pcm_native = false;
+
+	/**
+	 * The data is shared with the sources already loaded from the same file (same path, size
+	 * and date) or from a file with the same content, in all the mixers of the process :
+	 * the WAVE data, the QOA files, the Vorbis files played from memory and decoded to PCM.
+	 * The data is loaded once and released with its last source.
+	 */
+	bool shared_data = true;
+
+	/**
+	 * Asynchronous loading only (Majimix::add_source_async) : playing the source while it is
+	 * loading queues the play, the sample starts when the source is installed. If false the
+	 * play fails (play_source returns 0).
+	 */
+	bool queue_play = false;
+
+	/**
+	 * The source is only registered : the file is loaded in the background when the source is
+	 * first played (the play is queued) or prefetched (Majimix::prefetch_source).
+	 */
+	bool lazy = false;
+};
 
 
 class Majimix {
@@ -260,7 +369,8 @@ public:
 	 *
 	 * @brief Add a source to the mixer.
 	 * 
-	 * Add a source to the mixer. This source can be a wave file or a Vorbis file.
+	 * Add a source to the mixer. This source can be a wave file, a Vorbis file or a QOA file
+	 * (kept compressed in memory, each voice decodes the frames it plays).
 	 * The mixer doesn't have to be stopped or paused.
 	 * 
 	 * @attention Not compatible with kss file.
@@ -271,6 +381,99 @@ public:
 	 */
 	virtual int add_source(const std::string& name) = 0;
 
+	/**
+	 * @brief Add a source to the mixer with loading options.
+	 *
+	 * @param [in] name The filename of the source.
+	 * @param [in] options Loading options (see SourceOptions)
+	 * @return In case of success, an integer greater than 0, identifying the source (id or handle of the source), in case of failure 0.
+	 */
+	virtual int add_source(const std::string& name, const SourceOptions& options) = 0;
+
+	/**
+	 * @brief Add a source loaded in the background.
+	 *
+	 * Returns at once : the file is tested and loaded by a pool of loading threads, the
+	 * handle can be played when the loading is done (see SourceOptions::queue_play).
+	 * The loaded sources are installed by the next calls of the API (play_source,
+	 * get_source_status, wait_source, add_source...).
+	 * A source that failed to load keeps its handle (SourceFailed) until it is dropped.
+	 *
+	 * @param [in] name The filename of the source.
+	 * @param [in] options Loading options (see SourceOptions)
+	 * @return The source handle (greater than 0).
+	 */
+	virtual int add_source_async(const std::string& name, const SourceOptions& options = SourceOptions {}) = 0;
+
+	/**
+	 * @brief Add sources loaded in the background (add_source_async) - the files are loaded in parallel
+	 *
+	 * @param [in] names The filenames of the sources.
+	 * @param [in] options Loading options of all the sources
+	 * @return The source handles, in the order of the names.
+	 */
+	virtual std::vector<int> add_sources(const std::vector<std::string>& names, const SourceOptions& options = SourceOptions {}) = 0;
+
+	/**
+	 * @brief Add all the assets of a sound bank (built by majimix_bank_builder)
+	 *
+	 * The bank is mapped in memory : its directory is read in place and the assets are played
+	 * from the mapping, without copy - the pages are loaded by the system when they are played.
+	 * The PCM assets are played in the format they were converted to by the builder, the Vorbis
+	 * assets are decoded from the mapping (the vorbis_decoders, vorbis_loop_head_ms and
+	 * vorbis_seek_index options apply, the index is not saved).
+	 * The bank sources are not unloaded by the memory budget.
+	 *
+	 * @param [in] filename The bank file.
+	 * @param [in] options Loading options of the Vorbis assets
+	 * @return The source handles by asset name - empty if the file is not a valid bank.
+	 */
+	virtual std::map<std::string, int> add_bank(const std::string& filename, const SourceOptions& options = SourceOptions {}) = 0;
+
+	/**
+	 * @brief Get the status of a source
+	 *
+	 * @param [in] source_handle The handle identifying the source.
+	 * @return SourceLoading, SourceReady, SourceUnloaded (lazy or evicted source), SourceFailed
+	 *         or SourceInvalid (unknown handle)
+	 */
+	virtual int get_source_status(int source_handle) = 0;
+
+	/**
+	 * @brief Wait for the loading of a source
+	 *
+	 * @param [in] source_handle The handle identifying the source - 0 : all the sources
+	 * @param [in] timeout_ms Maximum waiting time - negative : no limit
+	 * @return The status of the source (SourceLoading if the time is out) - with 0,
+	 *         SourceLoading if a source is still loading, SourceReady otherwise.
+	 */
+	virtual int wait_source(int source_handle, int timeout_ms = -1) = 0;
+
+	/**
+	 * @brief Load an unloaded source (SourceOptions::lazy or evicted) in the background
+	 *
+	 * @param [in] source_handle The handle identifying the source.
+	 * @return false if the handle is not a source
+	 */
+	virtual bool prefetch_source(int source_handle) = 0;
+
+	/**
+	 * @brief Limit the memory used by the sources
+	 *
+	 * When the sources in memory (decoded PCM, Vorbis files and heads) use more than bytes,
+	 * the least recently played sources that are not playing are unloaded. They are loaded
+	 * again in the background when they are played (the play is queued) or prefetched.
+	 * The data shared by several sources is counted for each of them.
+	 *
+	 * @param [in] bytes the budget - 0 : no limit (default)
+	 */
+	virtual void set_memory_budget(size_t bytes) = 0;
+
+	/**
+	 * @brief Memory used by the sources in memory (bytes) - see set_memory_budget
+	 */
+	virtual size_t get_memory_usage() = 0;
+
 	/**
 	 * @brief KSS support for majimix
 	 * Add a KSS type source to the mixer
@@ -406,6 +609,28 @@ public:
 	virtual int get_kss_playtime_millis(int kss_play_handle) = 0;
 
 
+	/* ---------------- API TRACE -------------------*/
+
+	/**
+	 * @brief Record the API calls to a trace file
+	 *
+	 * Every state changing call (sources, playback, kss, volume, format) is written with the index
+	 * of the mixing block it is applied to. The current format and the loaded sources are written first.
+	 * The trace can be replayed offline with the majimix_replay tool (same output, per block timings).
+	 * The voices are not written : the trace can only be started while no sample nor KSS line is
+	 * playing or paused (stop_playback(0) first).
+	 *
+	 * @param [in] filename The trace file
+	 * @return True if the file was created - false if it can't be created or a voice is playing.
+	 */
+	virtual bool start_api_trace(const std::string& filename) = 0;
+
+	/**
+	 * @brief Stop recording the API calls and close the trace file.
+	 */
+	virtual void stop_api_trace() = 0;
+
+
     // TODO: update_volume - (not only kss version)
 	// TODO:  bool is_active(int handle) - active / paused (source / channel/track) kss compatible
 	// TODO  bool is_paused(int play_handle);
@@ -451,6 +676,38 @@ MAJIMIXAPI void APIENTRY terminate();
  */
 MAJIMIXAPI std::unique_ptr<Majimix> APIENTRY create_instance();
 
+
+/**
+ * @fn bool write_profile_trace(const std::string&)
+ * @brief Export the mixer profiling events to a Chrome trace / Perfetto JSON file.
+ *
+ * Events are only recorded when majimix is built with the MAJIMIX_PROFILE option :
+ * per stage timings of the mixing thread (Vorbis decode, resampling, KSS emulation, accumulation, encoding),
+ * per voice, and the producer / consumer timeline of the mixer buffers (waits and underruns).
+ * The export can run while the mixer plays : the events recorded meanwhile may be missing.
+ *
+ * @param filename the JSON file to write (can be opened with chrome://tracing or https://ui.perfetto.dev)
+ * @return true if the file was written, false on error or if profiling is not compiled in.
+ */
+MAJIMIXAPI bool APIENTRY write_profile_trace(const std::string &filename);
+
+
+/**
+ * @fn bool set_pcm_cache(const std::string&, size_t)
+ * @brief Keep the decoded Vorbis files (SourceOptions::vorbis_decode_max_ms / max_bytes) and the
+ * converted WAVE data (SourceOptions::pcm_native) in a directory.
+ *
+ * The next runs map the cache files instead of decoding or converting the files again : loading
+ * the sources costs page faults instead of CPU time. The cache files are checked against the size
+ * and date of their source file. Applies to the sources loaded with SourceOptions::shared_data,
+ * in all the mixers of the process - call it before adding the sources.
+ *
+ * @param directory the cache directory, created if needed - empty : no cache (default)
+ * @param max_bytes size limit of the directory : the least recently used files are removed
+ * @return false if the directory can't be created
+ */
+MAJIMIXAPI bool APIENTRY set_pcm_cache(const std::string &directory, size_t max_bytes);
+
 }
 
 
@@ -0,0 +1,1441 @@
+/**
+ * @file majimix_core.cpp
+ *
+ * @section majimix_core_desc_cpp DESCRIPTION
+ *
+ * This file contains the audio backend independent implementation of the Majimix mixer.
+ *
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright © 2022 - François Jacobs
+ * Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "majimix_core.hpp"
+#include "wave.hpp"
+#include "converters.hpp"
+#include "source_pcm.hpp"
+#include "source_wave_stream.hpp"
+#include "source_adpcm.hpp"
+#include "source_qoa.hpp"
+#include "source_vorbis.hpp"
+#include "profiler.hpp"
+#include "rt_check.hpp"
+#include "load_pool.hpp"
+#include "stream_pool.hpp"
+#include "sound_bank.hpp"
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+
+namespace majimix {
+//
+//int get_source_id(int handle) {return handle & 0xFFF;}
+//int get_channel_id(int handle) {return (handle >> 12) & 0xFFF;}
+//int get_handle(int source_id, int channel_id) {return ((channel_id & 0xFFF) << 12) | (source_id &0xFFF);}
+// channel number or kss line  (12 bits)      source type  (4 bits)     source handle (12 bits)
+//        0xFFFF                                        F                 FFF
+// Handle int (at least 32 bits)
+// bits  0-11 size 12 bits : source id (source index or kss cartdridge index)
+// bits 12-15 size  4 bits : source type (0 : wave ogg 1: kss)
+// bits 16-27 size 12 bits : channel number or kss line
+static int get_untyped_source_id(int handle) { return handle & 0xFFF; }
+static int get_source_id(int handle) { return handle & 0xFFFF; }
+static int get_channel_id(int handle) { return (handle >> 16) & 0xFFF; }
+static int get_handle(int source_id, int channel_id) { return ((channel_id & 0xFFF) << 16) | (source_id & 0xFFFF); }
+
+/* PCM source (WAVE files, decoded Vorbis files) */
+static std::unique_ptr<SourcePCM> make_pcm_source()
+{
+#ifdef MAJIMIX_USE_FLOATING_POINT
+#ifdef DEBUG
+	std::cout << "FLOATING POINT\n";
+#endif
+	return std::make_unique<SourcePCMF>();
+#else
+#ifdef DEBUG
+	std::cout << "FIXED POINT\n";
+#endif
+	return std::make_unique<SourcePCMI>();
+#endif
+}
+static int get_kss_source_id(int source_id) { return (source_id | 0x1000) & 0xFFFF; }
+static int get_source_type(int handle_or_source_id) { return (handle_or_source_id >> 12) & 0xF; }
+
+
+bool Majimix::start_mixer() 
+{
+	return start_stop_mixer(true);
+}
+
+bool Majimix::stop_mixer() 
+{
+	return start_stop_mixer(false);
+}
+
+bool Majimix::pause_mixer() 
+{
+	return pause_resume_mixer(true);
+}
+
+bool Majimix::resume_mixer() 
+{
+	return pause_resume_mixer(false);
+}
+
+void Majimix::pause_playback(int play_handle)
+{
+	pause_resume_playback(play_handle, true);
+}
+
+void Majimix::resume_playback(int play_handle)
+{
+	pause_resume_playback(play_handle, false);
+}
+
+MixerChannel::MixerChannel()
+: active  {false},
+//  started  {false}
+  stopped {true},
+  paused  {false},
+  loop    {false},
+  sample  {nullptr},
+  sid {0},
+  queued {false}
+
+{}
+
+
+/* ------------------- FORMAT ------------------------ */
+
+bool MajimixCore::set_format(int rate, bool stereo, int bits, int channel_count)
+{
+	trace::Call call(api_recorder, mixed_blocks, "set_format", rate, stereo, bits, channel_count);
+	if(!is_streaming())
+	{
+		if(rate >= 1000 && rate <= 96000 && (bits == 16 || bits == 24) )
+		{
+			sampling_rate = rate;
+			channels      = stereo ? 2 : 1;
+			this->bits    = bits;
+			mixer_channels.clear();
+			mixer_channels.reserve(channel_count);
+			for(int i = 0; i < channel_count; ++i)
+				mixer_channels.push_back(std::make_unique<MixerChannel>());
+
+			for(auto &source : sources)
+				if(source)
+					source->set_output_format(sampling_rate, channels, bits);
+			for(auto &cartridge : kss_cartridges)
+				if(cartridge)
+					cartridge->set_output_format(sampling_rate, channels, bits /*, 300*/);
+			// the converted data size depends on the format
+			enforce_memory_budget();
+
+#ifdef DEBUG
+			std::cout << "MajimixCore::set_format\n\tsampling_rate : "<<sampling_rate<<"\n\tchannels : "<<channels<<"\n\tbits : "<<bits<<"\n\tvoices : "<<channel_count<<"\n";
+#endif
+
+			if(bits == 16)
+				encode = std::bind(&MajimixCore::encode_Nbits<2>, this, std::placeholders::_1);
+			else
+				encode = std::bind(&MajimixCore::encode_Nbits<3>, this, std::placeholders::_1);
+
+			//  high latency : latency = bufsz * 5 * 1000  / 44100 = 100 ms (0.1 sec)
+			// => bufsz = 100 * rate / (buffer_count * 1000)
+			int buffer_count = 5;
+			int buffer_sample_size = 100 * rate / buffer_count / 1000;
+			if(mixer)
+			{
+				buffer_count = mixer->get_buffer_count();
+				buffer_sample_size = mixer->get_buffer_packet_sample_size();
+			}
+
+			return set_mixer_buffer_parameters(buffer_count, buffer_sample_size);
+		}
+	}
+	return false;
+}
+
+bool MajimixCore::set_mixer_buffer_parameters(int buffer_count, int buffer_sample_size)
+{
+	trace::Call call(api_recorder, mixed_blocks, "set_mixer_buffer_parameters", buffer_count, buffer_sample_size);
+	if(is_streaming()) return false;
+	mixer = std::make_unique<BufferedMixer>(buffer_count, buffer_sample_size, channels * (bits >> 3));
+
+	size_t buffer_size = static_cast<long>(mixer->get_buffer_packet_sample_size()) * channels;
+	internal_sample_buffer.assign(buffer_size, 0);
+	internal_mix_buffer.assign(buffer_size, 0);
+
+	mixer->set_mixer_function([this](std::vector<char>::iterator it_out, int requested_sample_count) {
+		mix(it_out, requested_sample_count);
+		// out of the real-time section : the decoders that need data are woken
+		StreamPool::instance().notify_requested();
+	});
+
+	// KSS support : the lines buffers must not be resized by the mixing thread
+	for(auto &cartridge : kss_cartridges)
+		if(cartridge)
+			cartridge->reserve(mixer->get_buffer_packet_sample_size());
+
+	return true;
+}
+
+/* ------------------- SOURCES ------------------------ */
+
+
+int MajimixCore::add_source(const std::string& name)
+{
+	return add_source(name, SourceOptions {});
+}
+
+/* test and load a file (caller thread or LoadPool) */
+static std::unique_ptr<Source> load_source(const std::string& name, const SourceOptions& options, bool decode_ahead)
+{
+	std::unique_ptr<Source> source;
+	
+	/* check wave format */
+	if(majimix::wave::test_wave(name))
+	{
+		// the headers are read once, the source is chosen from the format
+		// (heap : the data chunk is read with them, except for the files that can only be streamed)
+		wave::pcm_data pcm_data;
+		const bool read_data = !options.wave_mapped && !options.shared_data && !options.wave_streamed;
+		if(!wave::load_wave(name, pcm_data, read_data))
+			return source;
+		const auto format = wave::get_wave_format(pcm_data.fmt.wFormatTag);
+
+		// ADPCM : kept compressed in memory (not streamed)
+		if(format == wave::WAVE_FORMAT::WAVE_FORMAT_ADPCM || format == wave::WAVE_FORMAT::WAVE_FORMAT_IMA_ADPCM)
+		{
+			auto s = std::make_unique<SourceADPCM>();
+			s->set_shared(options.shared_data);
+			if(s->load_wave(name, pcm_data, options.wave_mapped))
+				source = std::move(s);
+		}
+		// long files (and the files too large to be loaded : RF64 and Wave64 over 2 GB) : read from the disk
+		else if(options.wave_streamed || pcm_data.data_size > static_cast<uint64_t>(INT32_MAX))
+		{
+			auto s = std::make_unique<SourceWaveStream>();
+			s->set_decode_ahead(decode_ahead);
+			if(s->set_file(name, pcm_data))
+				source = std::move(s);
+		}
+		else
+		{
+			auto s = make_pcm_source();
+			s->set_native(options.pcm_native);
+			s->set_shared(options.shared_data);
+			// FIXME: implementer totalement read
+			//if(load_wave(name, *s))
+			if(s->load_wave(name, pcm_data, options.wave_mapped))
+				source = std::move(s);
+		}
+	}
+	/* check QOA format */
+	else if(SourceQOA::test_qoa(name))
+	{
+		auto s = std::make_unique<SourceQOA>();
+		s->set_shared(options.shared_data);
+		if(s->load(name))
+			source = std::move(s);
+	}
+	else
+	/* check Vorbis format */
+	{
+		auto s = std::make_unique<SourceVorbis>();
+		s->set_decode_ahead(decode_ahead);
+		s->set_decoder_pool_size(options.vorbis_decoders);
+		s->set_loop_head(options.vorbis_loop_head_ms);
+		s->set_shared(options.shared_data);
+		if(s->set_file(name, options.vorbis_in_memory))
+		{
+			// short files : decoded once, played as PCM
+			AssetCache::Data pcm;
+			int rate, pcm_channels;
+			if(s->decode_to_pcm(options.vorbis_decode_max_ms, options.vorbis_decode_max_bytes, pcm, rate, pcm_channels))
+			{
+				auto p = make_pcm_source();
+				if(p->set_pcm(std::move(pcm), AuFormat::int_16bits, rate, pcm_channels, 2))
+				{
+					int64_t loop_start, loop_end;
+					if(s->get_loop_points(loop_start, loop_end))
+						p->set_loop_points(loop_start, loop_end);
+					source = std::move(p);
+				}
+			}
+			if(!source)
+			{
+				if(options.vorbis_seek_index)
+					s->build_seek_index(options.vorbis_seek_index_file);
+				source = std::move(s);
+			}
+		}
+
+		// std::ifstream stream(name, std::ios::binary);
+		// OggVorbis_File file;
+		// int result = ov_test_callbacks(&stream, &file, nullptr, 0, {ogg_read, ogg_seek, nullptr, ogg_tell});
+		// ov_clear(&file);
+		// if(!result)
+		// {
+		// 	auto s = std::make_unique<SourceVorbis>();
+		// 	s->set_file(name);
+		// 	source = std::move(s);
+		// }
+	}
+
+	return source;
+}
+
+int MajimixCore::add_source(const std::string& name, const SourceOptions& options)
+{
+	trace::Call call(api_recorder, mixed_blocks, "add_source", name, options.vorbis_in_memory, options.vorbis_decoders,
+	                 options.vorbis_decode_max_ms, options.vorbis_decode_max_bytes, options.vorbis_seek_index,
+	                 options.vorbis_seek_index_file, options.vorbis_loop_head_ms, options.wave_mapped, options.wave_streamed,
+	                 options.pcm_native, options.shared_data, options.queue_play, options.lazy);
+	update_pending_sources();
+	if(options.lazy)
+		return call.result(register_source(name, options));
+
+	int id = 0;
+	auto source = load_source(name, options, decode_ahead);
+	if(source)
+	{
+		// add source
+		source->set_output_format(sampling_rate, channels, bits);
+		id = insert_source(std::move(source));
+		source_records[id] = {name, false, 0, 0, options};
+		source_uses[id] = ++use_clock;
+		enforce_memory_budget();
+	}
+
+	return call.result(id);
+}
+
+int MajimixCore::add_source_async(const std::string& name, const SourceOptions& options)
+{
+	trace::Call call(api_recorder, mixed_blocks, "add_source_async", name, options.vorbis_in_memory, options.vorbis_decoders,
+	                 options.vorbis_decode_max_ms, options.vorbis_decode_max_bytes, options.vorbis_seek_index,
+	                 options.vorbis_seek_index_file, options.vorbis_loop_head_ms, options.wave_mapped, options.wave_streamed,
+	                 options.pcm_native, options.shared_data, options.queue_play, options.lazy);
+	update_pending_sources();
+	if(options.lazy)
+		return call.result(register_source(name, options));
+
+	// the slot is reserved until the source is installed
+	int id = insert_source(nullptr);
+	source_records[id] = {name, false, 0, 0, options};
+	load_async(id, name, options, options.queue_play);
+
+	return call.result(id);
+}
+
+std::vector<int> MajimixCore::add_sources(const std::vector<std::string>& names, const SourceOptions& options)
+{
+	std::vector<int> handles;
+	handles.reserve(names.size());
+	for(auto &name : names)
+		handles.push_back(add_source_async(name, options));
+	return handles;
+}
+
+std::map<std::string, int> MajimixCore::add_bank(const std::string& filename, const SourceOptions& options)
+{
+	// recorded when the handles are known
+	const uint64_t block = mixed_blocks;
+	update_pending_sources();
+
+	std::map<std::string, int> handles;
+	auto bank_handles = std::make_shared<std::vector<int>>();
+	SoundBank bank;
+	if(bank.open(filename))
+	{
+		// the directory is read in place, the assets are played from the mapping
+		bank_handles->resize(bank.size());
+		for(size_t i = 0; i < bank.size(); ++i)
+		{
+			const bank::Entry &entry = bank.entry(i);
+			std::unique_ptr<Source> source;
+			if(entry.kind == static_cast<uint32_t>(bank::Kind::pcm) && entry.format <= static_cast<uint32_t>(AuFormat::ulaw))
+			{
+				auto s = make_pcm_source();
+				if(s->set_mapped(bank.mapping(), entry.data_offset, entry.data_size, static_cast<AuFormat>(entry.format),
+				                 entry.rate, entry.channels, entry.channel_size))
+				{
+					if(entry.loop_end)
+						s->set_loop_points(entry.loop_start, entry.loop_end);
+					source = std::move(s);
+				}
+			}
+			else if(entry.kind == static_cast<uint32_t>(bank::Kind::vorbis))
+			{
+				auto s = std::make_unique<SourceVorbis>();
+				s->set_decode_ahead(decode_ahead);
+				s->set_decoder_pool_size(options.vorbis_decoders);
+				s->set_loop_head(options.vorbis_loop_head_ms);
+				if(s->set_mapped(std::string(bank.name(entry)), bank.data(entry), static_cast<size_t>(entry.data_size)))
+				{
+					if(options.vorbis_seek_index)
+						s->build_seek_index(false);
+					source = std::move(s);
+				}
+			}
+#ifdef DEBUG
+			if(!source)
+				std::cout << filename << " : asset " << bank.name(entry) << " can't be played\n";
+#endif
+			if(source)
+			{
+				source->set_output_format(sampling_rate, channels, bits);
+				int id = insert_source(std::move(source));
+				source_records[id] = {filename, false, 0, 0, options, bank_handles};
+				source_uses[id] = ++use_clock;
+				(*bank_handles)[i] = id;
+				handles.emplace(bank.name(entry), id);
+			}
+		}
+	}
+
+	std::ostringstream ids;
+	for(int id : *bank_handles)
+		ids << (ids.tellp() ? " " : "") << id;
+	trace::Call call(api_recorder, block, "add_bank", filename, options.vorbis_in_memory, options.vorbis_decoders,
+	                 options.vorbis_decode_max_ms, options.vorbis_decode_max_bytes, options.vorbis_seek_index,
+	                 options.vorbis_seek_index_file, options.vorbis_loop_head_ms, options.wave_mapped, options.wave_streamed,
+	                 options.pcm_native, options.shared_data, options.queue_play, options.lazy, ids.str());
+	call.result(static_cast<int>(handles.size()));
+	return handles;
+}
+
+void MajimixCore::load_async(int id, const std::string& name, const SourceOptions& options, bool queue_play)
+{
+	// the whole loading is done by the pool thread (file tests and reads, decoding, conversion)
+	auto task = std::make_shared<std::packaged_task<std::unique_ptr<Source>()>>(
+		[name, options, decode_ahead = decode_ahead, rate = sampling_rate, channels = channels, bits = bits] {
+			auto source = load_source(name, options, decode_ahead);
+			if(source)
+				source->set_output_format(rate, channels, bits);
+			return source;
+		});
+	pending_sources[id] = {task->get_future(), sampling_rate, channels, bits, queue_play};
+	LoadPool::instance().submit([task] { (*task)(); });
+}
+
+int MajimixCore::register_source(const std::string& name, const SourceOptions& options)
+{
+	std::error_code ec;
+	if(!std::filesystem::is_regular_file(name, ec))
+		return 0;
+	int id = insert_source(nullptr);
+	unloaded_sources.insert(id);
+	source_records[id] = {name, false, 0, 0, options};
+	return id;
+}
+
+int MajimixCore::insert_source(std::unique_ptr<Source> source)
+{
+	int i = 0;
+	for(auto &src : sources)
+	{
+		if(!src && !pending_sources.count(i+1) && !unloaded_sources.count(i+1))
+		{
+			src = std::move(source);
+			return i+1;
+		}
+		++i;
+	}
+	sources.push_back(std::move(source));
+	return i+1;
+}
+
+void MajimixCore::update_pending_sources()
+{
+	bool installed = false;
+	for(auto it = pending_sources.begin(); it != pending_sources.end();)
+	{
+		int id = it->first;
+		auto &pending = it->second;
+		if(!pending.loading.valid() || pending.loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		std::unique_ptr<Source> source;
+		try
+		{
+			source = pending.loading.get();
+		}
+		catch(const std::exception &e)
+		{
+#ifdef DEBUG
+			std::cout << "source " << id << " : " << e.what() << "\n";
+#endif
+		}
+
+		if(source)
+		{
+			// the format was changed while loading
+			if(pending.rate != sampling_rate || pending.channels != channels || pending.bits != bits)
+				source->set_output_format(sampling_rate, channels, bits);
+			sources[id-1] = std::move(source);
+			source_uses[id] = ++use_clock;
+			installed = true;
+		}
+
+		// queued plays
+		for(auto &channel : mixer_channels)
+		{
+			if(channel->queued && channel->sid == id)
+			{
+				channel->queued = false;
+				if(sources[id-1])
+					start_sample(*channel, true);
+				else
+					channel->sid = 0;
+			}
+		}
+
+		// failure : the handle is kept (SourceFailed) until drop_source
+		if(sources[id-1])
+			it = pending_sources.erase(it);
+		else
+			++it;
+	}
+
+	if(installed)
+		enforce_memory_budget();
+}
+
+void MajimixCore::enforce_memory_budget()
+{
+	if(!memory_budget)
+		return;
+
+	size_t usage = get_memory_usage();
+	while(usage > memory_budget)
+	{
+		// least recently used source not playing
+		int lru = 0;
+		uint64_t lru_use = 0;
+		for(auto &[id, use] : source_uses)
+		{
+			if(lru && use >= lru_use)
+				continue;
+			// the bank assets can't be loaded again by name (and are mostly mapped)
+			if(!sources[id-1]->memory_size() || source_records[id].bank)
+				continue;
+			bool playing = false;
+			for(auto &channel : mixer_channels)
+				playing = playing || (channel->sid == id && (channel->active || channel->queued));
+			if(!playing)
+			{
+				lru = id;
+				lru_use = use;
+			}
+		}
+		if(!lru)
+			break;
+
+#ifdef DEBUG
+		std::cout << "evict source " << lru << " (" << sources[lru-1]->memory_size() << " bytes)\n";
+#endif
+		// the stopped samples of the source
+		for(auto &channel : mixer_channels)
+		{
+			if(channel->sid == lru)
+			{
+				channel->sample.reset();
+				channel->sid = 0;
+			}
+		}
+		usage -= sources[lru-1]->memory_size();
+		sources[lru-1].reset();
+		source_uses.erase(lru);
+		unloaded_sources.insert(lru);
+	}
+}
+
+size_t MajimixCore::get_memory_usage()
+{
+	size_t usage = 0;
+	for(auto &[id, use] : source_uses)
+		usage += sources[id-1]->memory_size();
+	return usage;
+}
+
+void MajimixCore::set_memory_budget(size_t bytes)
+{
+	trace::Call call(api_recorder, mixed_blocks, "set_memory_budget", bytes);
+	memory_budget = bytes;
+	enforce_memory_budget();
+}
+
+bool MajimixCore::prefetch_source(int source_handle)
+{
+	trace::Call call(api_recorder, mixed_blocks, "prefetch_source", source_handle);
+	update_pending_sources();
+	int source_id = get_source_id(source_handle);
+	if(unloaded_sources.erase(source_id))
+	{
+		auto &record = source_records[source_id];
+		load_async(source_id, record.name, record.options, record.options.queue_play);
+		return true;
+	}
+	return source_id > 0 && source_id <= static_cast<int>(sources.size()) && (sources[source_id-1] || pending_sources.count(source_id));
+}
+
+int MajimixCore::get_source_status(int source_handle)
+{
+	trace::Call call(api_recorder, mixed_blocks, "get_source_status", source_handle);
+	update_pending_sources();
+	int source_id = get_source_id(source_handle);
+	int untyped_source_id = get_untyped_source_id(source_handle);
+	int status = SourceInvalid;
+	if(get_source_type(source_handle) == 1)
+	{
+		if(untyped_source_id > 0 && untyped_source_id <= static_cast<int>(kss_cartridges.size()) && kss_cartridges[untyped_source_id-1])
+			status = SourceReady;
+	}
+	else if(pending_sources.count(source_id))
+		status = pending_sources[source_id].loading.valid() ? SourceLoading : SourceFailed;
+	else if(unloaded_sources.count(source_id))
+		status = SourceUnloaded;
+	else if(source_id > 0 && source_id <= static_cast<int>(sources.size()) && sources[source_id-1])
+		status = SourceReady;
+	return call.result(status);
+}
+
+int MajimixCore::wait_source(int source_handle, int timeout_ms)
+{
+	trace::Call call(api_recorder, mixed_blocks, "wait_source", source_handle, timeout_ms);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+	for(auto &[id, pending] : pending_sources)
+	{
+		if((source_handle == 0 || id == get_source_id(source_handle)) && pending.loading.valid())
+		{
+			if(timeout_ms < 0)
+				pending.loading.wait();
+			else
+				pending.loading.wait_until(deadline);
+		}
+	}
+	update_pending_sources();
+
+	int status;
+	if(source_handle)
+		status = get_source_status(source_handle);
+	else
+	{
+		status = SourceReady;
+		for(auto &[id, pending] : pending_sources)
+			if(pending.loading.valid())
+				status = SourceLoading;
+	}
+	return call.result(status);
+}
+
+int MajimixCore::add_source_kss(const std::string& name, int lines, int silent_limit_ms)
+{
+	trace::Call call(api_recorder, mixed_blocks, "add_source_kss", name, lines, silent_limit_ms);
+	if (lines <= 0)
+		return call.result(-1);
+
+	KSS *kss = kss::load_kss(name);
+	if (!kss)
+		return call.result(-1);
+
+	auto cartridge = std::make_unique<kss::CartridgeKSS>(kss, lines, sampling_rate, channels, bits, silent_limit_ms);
+	if(mixer)
+		cartridge->reserve(mixer->get_buffer_packet_sample_size());
+
+
+	bool need_resume = mixer && mixer->is_active();
+	if(need_resume)
+		mixer->pause(true);
+
+
+	int id = 0;
+	int i = 0;
+
+	for(auto &c : kss_cartridges)
+	{
+		if(!c)
+		{
+#ifdef DEBUG
+			std::cout << "insert cartridge in slot "<<i<<"\n";
+#endif
+			c = std::move(cartridge);
+			//  kss_cartridges[i] = std::move(cartridge);
+			id = i+1;
+			break;
+		}
+		++i;
+	}
+
+	if(!id)
+	{
+#ifdef DEBUG
+		std::cout << "insert cartridge in new slot "<<i<<"\n";
+#endif
+		kss_cartridges.push_back(std::move(cartridge));
+		id = i+1;
+	}
+
+	if(need_resume)
+		mixer->pause(false);
+
+	source_records[get_kss_source_id(id)] = {name, true, lines, silent_limit_ms, {}};
+	return call.result(get_kss_source_id(id));
+}
+
+bool MajimixCore::drop_source(int source_handle)
+{
+	trace::Call call(api_recorder, mixed_blocks, "drop_source", source_handle);
+	int source_type = get_source_type(source_handle);
+	int source_id = get_source_id(source_handle);
+	int untyped_source_id = get_untyped_source_id(source_handle);
+
+	//bool drop_all = source_handle == 0;
+	bool dropped = false;
+
+	bool active = mixer && mixer->is_active();
+	if(active)
+		mixer->pause(true);
+
+	if (source_handle == 0)
+	{
+		// drop all
+		for (auto &mix_channel : mixer_channels)
+		{
+			mix_channel->active = false;
+			mix_channel->paused = false;
+			mix_channel->loop = false;
+			mix_channel->sample.reset();
+			mix_channel->sid = 0;
+			mix_channel->queued = false;
+		}
+
+		for (auto &s : sources)
+			s.reset();
+
+		for (auto &c : kss_cartridges)
+			c.reset();
+
+		// the loading threads results are dropped
+		pending_sources.clear();
+		unloaded_sources.clear();
+		source_uses.clear();
+		source_records.clear();
+		dropped = true;
+	}
+	else if (source_id > 0)
+	{
+		// Regular sources
+		if (source_type == 0)
+		{
+			for (auto &mix_channel : mixer_channels)
+			{
+				if (mix_channel->sid == source_id)
+				{
+					mix_channel->active = false;
+					mix_channel->paused = false;
+					mix_channel->loop = false;
+					mix_channel->sample.reset();
+					mix_channel->sid = 0;
+					mix_channel->queued = false;
+				}
+			}
+
+			if (untyped_source_id <= static_cast<int>(sources.size()))
+			{
+				sources[untyped_source_id - 1].reset();
+				dropped = true;
+			}
+			pending_sources.erase(source_id);
+			unloaded_sources.erase(source_id);
+			source_uses.erase(source_id);
+		}
+
+		// KSS sources
+		if (source_type == 1)
+		{
+			if (untyped_source_id <= static_cast<int>(kss_cartridges.size()))
+			{
+				kss_cartridges[untyped_source_id - 1].reset();
+				dropped = true;
+			}
+		}
+	}
+
+	if (active)
+		mixer->pause(false);
+
+	if (dropped && source_handle)
+		source_records.erase(source_id);
+
+	return dropped;
+}
+
+
+/* ------------------- SAMPLES ------------------------ */
+
+int MajimixCore::play_source(int source_handle, bool loop, bool paused)
+{
+	trace::Call call(api_recorder, mixed_blocks, "play_source", source_handle, loop, paused);
+	update_pending_sources();
+	recycle_stopped_samples();
+	int source_id = get_source_id(source_handle);
+	// source not in memory : loaded again, the play is queued
+	if(get_source_type(source_handle) == 0 && unloaded_sources.erase(source_id))
+	{
+		auto &record = source_records[source_id];
+		load_async(source_id, record.name, record.options, true);
+	}
+	// source still loading : the play is queued or fails
+	auto pending = pending_sources.find(source_id);
+	bool queue = pending != pending_sources.end() && pending->second.loading.valid() && pending->second.queue_play;
+	if(queue || (source_id > 0 && source_id <= static_cast<int>(sources.size()) && sources[source_id-1]))
+	{
+		int pid = 0;
+		for(auto& mix_channel : mixer_channels)
+		{
+			++pid;
+			if(!mix_channel->active && !mix_channel->queued)
+			{
+				bool created = mix_channel->sid != source_id;
+				if(created)
+				{
+					// the previous sample goes back to its source
+					if(mix_channel->sample && mix_channel->sid > 0 && mix_channel->sid <= static_cast<int>(sources.size()) && sources[mix_channel->sid-1])
+						sources[mix_channel->sid-1]->recycle_sample(std::move(mix_channel->sample));
+					mix_channel->sample.reset();
+					mix_channel->sid     = source_id;
+				}
+				mix_channel->stopped = false;
+				mix_channel->loop    = loop;
+				mix_channel->paused  = paused;
+				if(queue)
+					mix_channel->queued = true;
+				else
+				{
+					start_sample(*mix_channel, created);
+					source_uses[source_id] = ++use_clock;
+				}
+
+				return call.result(get_handle(source_id, pid));
+			}
+		}
+	}
+	return call.result(0);
+}
+
+void MajimixCore::recycle_stopped_samples()
+{
+	// inactive voice : the mixer no longer reads its sample
+	for(auto &channel : mixer_channels)
+	{
+		if(channel->active || channel->queued || !channel->sample
+		   || channel->sid <= 0 || channel->sid > static_cast<int>(sources.size()) || !sources[channel->sid-1])
+			continue;
+		auto &source = sources[channel->sid-1];
+		if(source->recycles_samples())
+		{
+			source->recycle_sample(std::move(channel->sample));
+			channel->sample.reset();
+			channel->sid = 0;
+		}
+	}
+}
+
+void MajimixCore::start_sample(MixerChannel &channel, bool created)
+{
+	if(created)
+	{
+		// the loop state is known before the sample decodes ahead : no seek
+		channel.sample = sources[channel.sid-1]->create_sample(channel.loop);
+	}
+	else if(channel.sample)
+	{
+		// loop state first : the samples decoded ahead stop at their loop end
+		channel.sample->set_loop(channel.loop);
+		channel.sample->seek(0);
+	}
+	channel.active = true;
+}
+
+int MajimixCore::play_kss_track(int kss_source_handle, int track, bool autostop, bool forcable, bool force)
+{
+	trace::Call call(api_recorder, mixed_blocks, "play_kss_track", kss_source_handle, track, autostop, forcable, force);
+	return call.result(kss_cartridge_action<int>(kss_source_handle, false, false, 0, [&](kss::CartridgeKSS &cartridge, int line_id) -> int {
+		int id = cartridge.active_line(track, autostop, forcable);
+		if(!id && force)
+		{
+			// no free line : we have to force
+			bool need_reactive = mixer && mixer->is_active();
+			if (need_reactive)
+				mixer->pause(true);
+
+			id = cartridge.force_line(track, autostop, forcable);
+
+			if (need_reactive)
+				mixer->pause(false);
+		}
+
+		if(id) 
+		{
+			// found a line : return the play_handle
+			return get_handle(kss_source_handle, id);
+		}
+		return 0;
+	}));
+}
+
+bool MajimixCore::update_kss_track(int kss_handle, int new_track, bool autostop, bool forcable, int fade_out_ms)
+{
+	trace::Call call(api_recorder, mixed_blocks, "update_kss_track", kss_handle, new_track, autostop, forcable, fade_out_ms);
+	return kss_cartridge_action<bool>(kss_handle, true, true, false, [&new_track, &autostop, &forcable, &fade_out_ms](kss::CartridgeKSS &cartridge, int line_id) -> bool {
+		return cartridge.update_line(line_id, new_track, autostop, forcable, fade_out_ms); 
+	});
+}
+
+void MajimixCore::stop_playback(int play_handle)
+{
+	trace::Call call(api_recorder, mixed_blocks, "stop_playback", play_handle);
+	if (play_handle == 0)
+	{
+		// stop all
+
+		// Channels
+		for (auto& mix_channel : mixer_channels)
+		{
+			mix_channel->queued = false;
+			if (mix_channel->active)
+			{
+				mix_channel->stopped = true;
+				mix_channel->paused = false;
+
+				// TODO:  Please verify this !
+				if (!is_streaming()) 
+				{
+					mix_channel->loop = false;   // XXX needed ?
+					mix_channel->active = false; // XXX needed ?
+				}
+			}
+		}
+
+		// KSS
+		for (auto& cartridge : kss_cartridges)
+			if (cartridge)
+				cartridge->stop_active();
+
+	}
+	else if (get_source_type(play_handle) == 1)
+	{
+		// KSS
+		bool is_sample = get_channel_id(play_handle);
+		kss_cartridge_action<bool>(play_handle, false, is_sample, false, [&is_sample](kss::CartridgeKSS &cartridge, int line_id) -> bool {
+			
+			if (is_sample)
+				cartridge.stop(line_id);
+			else
+				cartridge.stop_active();
+
+			return true;
+		});
+	}
+	else
+	{
+		// Channels
+		unsigned int source_id   = get_source_id(play_handle);
+		unsigned int channel_id  = get_channel_id(play_handle);
+
+		if (source_id)
+		{
+			if (channel_id)
+			{
+				auto &channel = mixer_channels[channel_id - 1];
+				if (static_cast<int>(source_id) == channel->sid)
+					channel->queued = false;
+				if (channel->active && static_cast<int>(source_id) == channel->sid)
+				{
+					channel->stopped = true;
+					if(!is_streaming()) 
+							channel->active = false;
+				}
+			}
+			else
+			{
+				for (auto &channel : mixer_channels)
+				{
+					if (static_cast<int>(source_id) == channel->sid)
+						channel->queued = false;
+					if (channel->active && static_cast<int>(source_id) == channel->sid)
+					{
+						channel->stopped = true;
+						if(!is_streaming()) 
+							channel->active = false;
+					}
+				}
+			}
+		}
+	}
+	recycle_stopped_samples();
+}
+
+/* ---------------------- OTHERS ----------------------------- */
+
+
+void MajimixCore::set_master_volume(int v)
+{
+	trace::Call call(api_recorder, mixed_blocks, "set_master_volume", v);
+	master_volume.store(v & 0xFF);
+
+}
+
+bool MajimixCore::update_kss_volume(int kss_handle, int volume)
+{
+	trace::Call call(api_recorder, mixed_blocks, "update_kss_volume", kss_handle, volume);
+	bool is_sample = get_channel_id(kss_handle);
+	return kss_cartridge_action<bool>(kss_handle, true, is_sample, false, [&volume, &is_sample](kss::CartridgeKSS &cartridge, int line_id) -> bool {
+		
+		if(is_sample)
+			cartridge.set_line_volume(line_id, volume);
+		else
+			cartridge.set_master_volume(volume);
+		return true;
+
+	});
+}
+
+void MajimixCore::pause_producer(bool pause) // test
+{
+	if(mixer)
+		mixer->pause(pause);
+}
+
+void MajimixCore::set_loop(int play_handle, bool loop)
+{
+	trace::Call call(api_recorder, mixed_blocks, "set_loop", play_handle, loop);
+	unsigned int source_id   = get_source_id(play_handle);
+	unsigned int channel_id  = get_channel_id(play_handle);
+	if(source_id && channel_id)
+	{
+		mixer_channels[channel_id-1]->loop = loop;
+		if(mixer_channels[channel_id-1]->sample)
+			mixer_channels[channel_id-1]->sample->set_loop(loop);
+	}
+}
+
+
+void MajimixCore::pause_resume_playback(int play_handle, bool pause)
+{
+	trace::Call call(api_recorder, mixed_blocks, "pause_resume_playback", play_handle, pause);
+	if (play_handle == 0)
+	{
+		// Pause/resume all samples (channels & KSS)
+
+		// Channels
+		for (auto &channel : mixer_channels)
+			if (channel->active || channel->queued)
+				channel->paused = pause;
+
+		// KSS
+		for (auto &cartridge : kss_cartridges)
+			if (cartridge)
+				cartridge->set_pause_active(pause);
+	}
+	else if (get_source_type(play_handle) == 1)
+	{
+		// KSS
+		bool is_sample = get_channel_id(play_handle);
+		/*bool bdone = */ kss_cartridge_action<bool>(play_handle, false, is_sample, false, [&pause, &is_sample](kss::CartridgeKSS &cartridge, int line_id) -> bool {
+			if (is_sample)
+				cartridge.set_pause(line_id, pause);
+			else
+				cartridge.set_pause_active(pause);
+			return true;
+		});
+	}
+	else
+	{
+		// Channels
+		unsigned int source_id = get_source_id(play_handle);
+		unsigned int channel_id = get_channel_id(play_handle);
+
+		if (source_id)
+		{
+			if (channel_id)
+			{
+				auto &channel = mixer_channels[channel_id - 1];
+				if ((channel->active || channel->queued) && static_cast<int>(source_id) == channel->sid)
+					channel->paused = pause;
+			}
+			else
+			{
+				for (auto &channel : mixer_channels)
+				{
+					if ((channel->active || channel->queued) && static_cast<int>(source_id) == channel->sid)
+						channel->paused = pause;
+				}
+			}
+		}
+	}
+}
+
+void MajimixCore::mix(std::vector<char>::iterator it_out, int requested_sample_count)
+{
+	//auto it_begin = it_out;
+	MAJIMIX_PROFILE_SCOPE(mix);
+	MAJIMIX_RT_SECTION();
+	// api trace : the calls made from now are applied to the next block
+	mixed_blocks.fetch_add(1, std::memory_order_relaxed);
+	int sample_count;
+	bool deactivate;
+
+	std::fill(internal_mix_buffer.begin(), internal_mix_buffer.end(), 0);
+
+#ifdef MAJIMIX_PROFILE
+	int voice = 0;
+#endif
+	for(auto& mix_channel : mixer_channels)
+	{
+#ifdef MAJIMIX_PROFILE
+		MAJIMIX_PROFILE_VOICE(++voice);
+#endif
+		if(mix_channel->active)
+		{
+			sample_count = 0;
+			deactivate =  false;
+			if(mix_channel->stopped || !mix_channel->sample)
+			{
+				deactivate = true;
+			}
+			else if(!mix_channel->paused)
+			{
+
+				// TODO: stop using internal_sample_buffer but use directly internal_mix_buffer to avoid a copy ?
+
+				{
+					MAJIMIX_PROFILE_SCOPE(voice);
+					sample_count = mix_channel->sample->read(&internal_sample_buffer[0], requested_sample_count);
+					if(mix_channel->loop && sample_count < requested_sample_count)
+					{
+						while(sample_count < requested_sample_count)
+						{
+							// EOF - AUTOLOOP 
+							long idx = static_cast<long>(sample_count) * channels;
+							sample_count += mix_channel->sample->read(&internal_sample_buffer[0] + idx, requested_sample_count - sample_count);
+						}
+					}
+				}
+
+				if(sample_count)
+				{
+					MAJIMIX_PROFILE_SCOPE(accumulate);
+					std::transform(internal_sample_buffer.begin(), internal_sample_buffer.begin() + static_cast<long>(sample_count) * channels, internal_mix_buffer.begin(), internal_mix_buffer.begin(), std::plus<int>());
+				}
+				if(sample_count < requested_sample_count)
+				{
+					deactivate = true;
+				}
+			}
+			if(deactivate)
+			{
+				mix_channel->stopped = true;
+				mix_channel->active = false;
+			}
+		}
+	}
+
+	MAJIMIX_PROFILE_VOICE(-1);
+
+	// kss support
+
+	for(auto &ck : kss_cartridges)
+	{
+		if(ck)
+		{
+			ck->read(internal_mix_buffer.begin(), requested_sample_count);
+		}
+	}
+
+	MAJIMIX_PROFILE_SCOPE(encode);
+
+	// volume adjustment
+	int vol = master_volume; // .load();
+	std::for_each(internal_mix_buffer.begin(), internal_mix_buffer.end(), [&vol](int &n){ n = ((int_fast64_t) n * vol) >> 8; });
+
+	encode(it_out);
+}
+
+
+template<int N>
+void MajimixCore::encode_Nbits(std::vector<char>::iterator it_out)
+{
+	for(const auto &v : internal_mix_buffer)
+	{
+		*it_out++ = v & 0xFF;
+		*it_out++ = (v >> 8) & 0xFF;
+		if constexpr (N == 3)
+			*it_out++ = (v >> 16) & 0xFF;
+	}
+}
+
+template void MajimixCore::encode_Nbits<2>(std::vector<char>::iterator it_out);
+template void MajimixCore::encode_Nbits<3>(std::vector<char>::iterator it_out);
+
+/* --------------------------  KSS SUPPORT -------------------------- */
+
+bool MajimixCore::get_cartrigde_and_line(int kss_handle, bool need_line, kss::CartridgeKSS *&cartridge, int &line_id)
+{
+	int idx;
+	if(get_source_type(kss_handle) == 1 && (idx = get_untyped_source_id(kss_handle)))
+	{
+		--idx;
+		if(static_cast<size_t>(idx) < kss_cartridges.size())
+		{
+			cartridge =  kss_cartridges[idx].get();
+			if(cartridge)
+			{
+				line_id = get_channel_id(kss_handle);
+				return !need_line || (line_id >0 && line_id <= cartridge->get_line_count());
+			}
+		}
+	}
+	return false;
+}
+
+template <typename T>
+T MajimixCore::kss_cartridge_action(int kss_source_handle, bool need_sync, bool need_line, T default_ret_val, std::function<T(kss::CartridgeKSS &, int line_id)> fn_action)
+{
+	kss::CartridgeKSS *cartridge;
+	int line_id;
+	if (get_cartrigde_and_line(kss_source_handle, need_line, cartridge, line_id))
+	{
+		bool need_reactive = need_sync && mixer && mixer->is_active();
+		if (need_reactive)
+			mixer->pause(true);
+
+		T ret_val = fn_action(*cartridge, line_id);
+
+		if (need_reactive)
+			mixer->pause(false);
+
+		return ret_val;
+	}
+	return default_ret_val;
+}
+
+bool MajimixCore::update_kss_frequency(int kss_handle, int frequency)
+{
+	trace::Call call(api_recorder, mixed_blocks, "update_kss_frequency", kss_handle, frequency);
+	if(kss_handle)
+	{
+		bool is_sample = get_channel_id(kss_handle);
+		return kss_cartridge_action<bool>(kss_handle, true, is_sample, false, [&frequency, &is_sample](kss::CartridgeKSS &cartridge, int line_id) -> bool {
+			if(is_sample)					 			   
+				cartridge.set_kss_line_frequency(line_id, frequency);
+			else
+				cartridge.set_kss_frequency(frequency);
+			return true;
+
+		});
+	}
+
+	bool need_reactive = mixer && mixer->is_active();
+	if (need_reactive)
+		mixer->pause(true);
+	
+	for(auto &c : kss_cartridges)
+		if(c)
+			c->set_kss_frequency(frequency);
+	
+	if (need_reactive)
+		mixer->pause(false);
+		
+	return true;
+}
+
+bool MajimixCore::start_api_trace(const std::string& filename)
+{
+	// a voice can't be replayed from where it is : the trace starts with no voice (nor queued play)
+	bool playing = false;
+	for(auto &channel : mixer_channels)
+		playing = playing || channel->queued || (channel->active && !channel->stopped);
+	for(auto &cartridge : kss_cartridges)
+		if(cartridge)
+			for(auto &line : *cartridge)
+				playing = playing || line->active;
+	if(playing)
+	{
+#ifdef DEBUG
+		std::cout << "start_api_trace : voices are playing\n";
+#endif
+		return false;
+	}
+	if(!api_recorder.open(filename))
+		return false;
+
+	// current state : format, buffers, volume and loaded sources
+	uint64_t block = mixed_blocks;
+	std::ostringstream os;
+	os << block << " set_format " << sampling_rate << ' ' << (channels == 2) << ' ' << bits << ' ' << mixer_channels.size() << '\n';
+	if(mixer)
+		os << block << " set_mixer_buffer_parameters " << mixer->get_buffer_count() << ' ' << mixer->get_buffer_packet_sample_size() << '\n';
+	os << block << " set_master_volume " << master_volume << '\n';
+	auto write_options = [&os](const SourceOptions &options) {
+		os << ' ' << options.vorbis_in_memory << ' ' << options.vorbis_decoders
+		   << ' ' << options.vorbis_decode_max_ms << ' ' << options.vorbis_decode_max_bytes
+		   << ' ' << options.vorbis_seek_index << ' ' << options.vorbis_seek_index_file
+		   << ' ' << options.vorbis_loop_head_ms << ' ' << options.wave_mapped << ' ' << options.wave_streamed
+		   << ' ' << options.pcm_native << ' ' << options.shared_data << ' ' << options.queue_play << ' ' << options.lazy;
+	};
+	std::set<const std::vector<int> *> banks;
+	for(auto &[handle, record] : source_records)
+	{
+		if(record.kss)
+			os << block << " add_source_kss " << std::quoted(record.name) << ' ' << record.lines << ' ' << record.silent_limit_ms << " = " << handle << '\n';
+		else if(record.bank)
+		{
+			// one line per bank : its assets still loaded
+			if(!banks.insert(record.bank.get()).second)
+				continue;
+			std::ostringstream ids;
+			int count = 0;
+			for(int id : *record.bank)
+			{
+				auto it = source_records.find(id);
+				bool loaded = id && it != source_records.end() && it->second.bank == record.bank;
+				ids << (ids.tellp() ? " " : "") << (loaded ? id : 0);
+				count += loaded;
+			}
+			os << block << " add_bank " << std::quoted(record.name);
+			write_options(record.options);
+			os << ' ' << std::quoted(ids.str()) << " = " << count << '\n';
+		}
+		else
+		{
+			os << block << " add_source " << std::quoted(record.name);
+			write_options(record.options);
+			os << " = " << handle << '\n';
+		}
+	}
+	std::string snapshot = os.str();
+	snapshot.pop_back();
+	api_recorder.write(snapshot);
+	return true;
+}
+
+void MajimixCore::stop_api_trace()
+{
+	api_recorder.close(mixed_blocks);
+}
+
+int MajimixCore::get_kss_active_lines_count(int kss_source_handle)
+{
+	 return kss_cartridge_action<int>(kss_source_handle, false, false, 0, [](kss::CartridgeKSS& cartridge, int line_id) -> int 
+	 {
+		int nb = 0;
+		for(auto &l : cartridge)
+		{
+			if(l->active)
+				++nb;
+		}
+		return nb;
+	});
+}
+
+int MajimixCore::get_kss_playtime_millis(int kss_play_handle) 
+{
+	return kss_cartridge_action<int>(kss_play_handle, false, true, 0, [](kss::CartridgeKSS& cartridge, int line_id) -> int 
+	 {
+		return cartridge.get_playtime_millis(line_id);
+	});
+}
+
+int MajimixCore::get_block_sample_size() const
+{
+	return mixer ? mixer->get_buffer_packet_sample_size() : 0;
+}
+
+int MajimixCore::render(std::vector<char> &out)
+{
+	if(!mixer || is_streaming() || mixer->is_started())
+		return 0;
+	int block_sample_size = mixer->get_buffer_packet_sample_size();
+	out.resize(static_cast<size_t>(mixer->get_buffer_packet_size()));
+	MAJIMIX_PROFILE_THREAD_RING(render_ring, "majimix render");
+	mix(out.begin(), block_sample_size);
+	StreamPool::instance().notify_requested();
+	return block_sample_size;
+}
+
+
+/* ---------------------- OFFLINE ----------------------------- */
+
+MajimixOffline::MajimixOffline()
+{
+	decode_ahead = false;
+#ifdef MAJIMIX_PROFILE
+	// the first mix records without allocating the ring of the render() caller
+	render_ring = profiler::register_ring("majimix render");
+#endif
+}
+
+void MajimixOffline::set_decode_ahead(bool enable)
+{
+	decode_ahead = enable;
+}
+
+bool MajimixOffline::is_streaming() const
+{
+	return false;
+}
+
+bool MajimixOffline::start_stop_mixer(bool start)
+{
+	if(start && !mixer)
+		return false;
+	started = start;
+	paused = false;
+	return true;
+}
+
+bool MajimixOffline::pause_resume_mixer(bool pause)
+{
+	if(!started)
+		return pause;
+	paused = pause;
+	return true;
+}
+
+int MajimixOffline::get_mixer_status()
+{
+	return started ? (paused ? MixerPaused : MixerRunning) : MixerStopped;
+}
+
+} // namespace majimix
@@ -0,0 +1,349 @@
+/**
+ * @file majimix_core.hpp
+ *
+ * @section majimix_core_desc_hpp DESCRIPTION
+ *
+ * Audio backend independent part of the Majimix mixer : sources, mixer channels,
+ * kss cartridges, mixing and encoding.
+ * The PortAudio implementation (majimix.cpp) derives from MajimixCore, MajimixOffline
+ * renders the mix without any audio device (benchmarks, tools, build servers).
+ *
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright © 2022 - François Jacobs
+ * Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef MAJIMIX_CORE_HPP_
+#define MAJIMIX_CORE_HPP_
+
+#include "majimix.hpp"
+#include "interfaces.hpp"
+#include "kss.hpp"
+#include "mixer_buffer.hpp"
+#include "api_trace.hpp"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+namespace majimix {
+
+/**
+ * @class MixerChannel
+ * @brief
+ *
+ */
+struct MixerChannel {
+	std::atomic<bool> active;     // Set to true to activate the Channel. If PA thread is active, it is the only thread that can reset the value.
+	std::atomic<bool> stopped;
+	std::atomic<bool> paused;
+	std::atomic<bool> loop;
+
+
+	std::unique_ptr<Sample> sample;
+	int sid; // FIXME atomic ! (cf stop_playback)
+	/* the play waits for its source (SourceOptions::queue_play) - API thread only */
+	bool queued;
+//	friend class MajimixPa;
+// public:
+
+	MixerChannel();
+
+};
+
+
+/**
+ * @class MajimixCore
+ * @brief Audio backend independent implementation of Majimix.
+ *
+ * Implements everything but the audio output : start / pause / status of the mixer
+ * are left to the backend.
+ */
+class MajimixCore : public Majimix {
+
+protected:
+	std::unique_ptr<BufferedMixer> mixer;
+	std::vector<std::unique_ptr<Source>> sources;
+	std::vector<std::unique_ptr<MixerChannel>> mixer_channels;
+	// kss support - kss sources
+	std::vector<std::unique_ptr<kss::CartridgeKSS>> kss_cartridges;
+
+
+
+	/* mixer parameters */
+	int sampling_rate = 44100;
+	int channels = 2;
+	int bits = 16; 			// 16 / 24
+
+	/* 0 - 255 */
+	std::atomic_int master_volume = 128;
+
+	/* Vorbis sources decoded ahead by the StreamPool workers (set before adding the sources) */
+	bool decode_ahead = true;
+
+	/* profiler ring of the render() caller - registered up front by MajimixOffline (MAJIMIX_PROFILE) */
+	profiler::EventRing *render_ring = nullptr;
+
+	/* sources loaded by the LoadPool (add_source_async) : their slot in sources is reserved */
+	struct PendingSource {
+		/** the loaded source (nullptr : failure) - not valid : the loading failed */
+		std::future<std::unique_ptr<Source>> loading;
+		/** output format set by the loading thread */
+		int rate;
+		int channels;
+		int bits;
+		bool queue_play;
+	};
+	std::map<int, PendingSource> pending_sources;
+
+	/* memory budget of the sources (set_memory_budget) - 0 : no limit */
+	size_t memory_budget = 0;
+	/* sources registered but not in memory (lazy or evicted) : loaded again from their source_records */
+	std::set<int> unloaded_sources;
+	/* last use of the sources in memory (LRU eviction) */
+	std::map<int, uint64_t> source_uses;
+	uint64_t use_clock = 0;
+
+	/* internal mixing data */
+	std::vector<int32_t> internal_mix_buffer;
+	std::vector<int32_t> internal_sample_buffer;
+
+	/* audio converter */
+	using fn_encode = std::function<void(std::vector<char>::iterator it_out)>;
+	fn_encode encode;
+
+	/* api trace */
+	struct SourceRecord {
+		std::string name;
+		bool kss;
+		int lines;
+		int silent_limit_ms;
+		SourceOptions options;
+		/** bank asset (name : the bank) : handles of the bank assets by name order (0 : not added or dropped) */
+		std::shared_ptr<std::vector<int>> bank = nullptr;
+	};
+	/** number of mixed blocks - the block index of the recorded calls */
+	std::atomic<uint64_t> mixed_blocks {0};
+	trace::ApiRecorder api_recorder;
+	/** loaded sources by handle (written at the beginning of a trace) */
+	std::map<int, SourceRecord> source_records;
+
+	/**
+	 * @brief Tell if an audio stream is opened by the backend.
+	 *        The format and the buffers can only be changed when there is no stream.
+	 */
+	virtual bool is_streaming() const = 0;
+
+	/**
+	 * @brief Get a CartridgeKSS an a KSSLine from a kss handle
+	 *
+	 * @param kss_handle
+	 * @param need_line  True : Tell if the kss handle must represent a valid kss line. False : the kss handle must be a valid kss source (but can eventualy contains a line)
+	 * @param cartridge
+	 * @param line_id
+	 * @return
+	 */
+	bool get_cartrigde_and_line(int kss_handle, bool need_line, kss::CartridgeKSS *&cartridge, int &line_id);
+
+	/**
+	 * @brief Store a source in a free slot (not reserved by a pending source)
+	 * @return the source id
+	 */
+	int insert_source(std::unique_ptr<Source> source);
+
+	/**
+	 * @brief Load a source on the LoadPool - its slot (id) is reserved until it is installed
+	 */
+	void load_async(int id, const std::string& name, const SourceOptions& options, bool queue_play);
+
+	/**
+	 * @brief Register a source without loading it (SourceOptions::lazy)
+	 * @return the source id - 0 if the file does not exist
+	 */
+	int register_source(const std::string& name, const SourceOptions& options);
+
+	/**
+	 * @brief Unload the least recently used sources that are not playing while the memory
+	 *        used by the sources exceeds the budget
+	 */
+	void enforce_memory_budget();
+
+	/**
+	 * @brief Install the sources loaded by the LoadPool and start their queued plays (API thread)
+	 */
+	void update_pending_sources();
+
+	/**
+	 * @brief Start the sample of a mixer channel (sid, loop and paused are set)
+	 * @param created the sample is created (false : the channel sample is played again)
+	 */
+	void start_sample(MixerChannel &channel, bool created);
+	/**
+	 * @brief Give the samples of the voices stopped by the mixer back to their sources
+	 *        (Source::recycles_samples) - API thread
+	 */
+	void recycle_stopped_samples();
+
+	template<typename T>
+	T kss_cartridge_action(int kss_source_handle, bool need_sync, bool need_line, T default_ret_val, std::function<T(kss::CartridgeKSS&, int line_id)> fn_action);
+
+public:
+	bool set_format(int rate, bool stereo = true, int bits = 16, int channel_count = 6) override;
+
+	/* obtain a source handle */
+
+	/**
+	 * @brief Add a source to the mixer (wave, ogg)
+	 *
+	 * @param name the source filename
+	 * @return int the handle
+	 */
+	int add_source(const std::string& name) override;
+	int add_source(const std::string& name, const SourceOptions& options) override;
+	int add_source_async(const std::string& name, const SourceOptions& options = SourceOptions {}) override;
+	std::vector<int> add_sources(const std::vector<std::string>& names, const SourceOptions& options = SourceOptions {}) override;
+	std::map<std::string, int> add_bank(const std::string& filename, const SourceOptions& options = SourceOptions {}) override;
+	int get_source_status(int source_handle) override;
+	int wait_source(int source_handle, int timeout_ms = -1) override;
+	bool prefetch_source(int source_handle) override;
+	void set_memory_budget(size_t bytes) override;
+	size_t get_memory_usage() override;
+
+	/**
+	 * @brief Add a kss source to the mixer
+	 *
+	 * @param name kss file
+	 * @param lines the number of lines (channels)
+	 * @param silent_limit_ms silent duration for autostop detection
+	 * @return int
+	 */
+	int add_source_kss(const std::string &name, int lines, int silent_limit_ms) override;
+
+	/**
+	 * @brief Drop a source from the mixer.
+	 *        Can be called at any time.
+	 *
+	 * @param source_handle
+	 * @return true the source has successfully been removed
+	 * @return false the source handle is not valid
+	 */
+	bool drop_source(int source_handle) override;
+
+	void set_master_volume(int v) override;
+	int play_source(int source_handle, bool loop = false, bool paused = false) override;
+	void stop_playback(int play_handle) override;
+	void set_loop(int play_handle, bool loop) override;
+    void pause_resume_playback(int play_handle, bool pause) override;
+
+	void pause_producer(bool);
+	bool set_mixer_buffer_parameters(int buffer_count, int buffer_sample_size) override;
+
+	int play_kss_track(int kss_handle, int track, bool autostop = true, bool forcable = true, bool force = true) override;
+	bool update_kss_track(int kss_handle, int new_track, bool autostop = true, bool forcable = true, int fade_out_ms = 0) override;
+
+	/**
+	 * @brief Update volume
+	 *
+	 * Update volume for a specific line of a kss source of for all lines of a kss source.
+	 *
+	 * @param [in] kss_handle A kss source handle or a kss track handle.
+	 * @param [in] volume Volume value between 0 and 100
+	 * @return True if successful / False for an invalid \c kss_track_handle.
+	 */
+	bool update_kss_volume(int kss_handle, int volume) override;
+	bool update_kss_frequency(int kss_source_handle, int frequency) override;
+	// bool set_pause_kss(int kss_handle, bool pause);
+	int get_kss_active_lines_count(int kss_source_handle) override;
+	int get_kss_playtime_millis(int kss_play_handle) override;
+
+	bool start_api_trace(const std::string& filename) override;
+	void stop_api_trace() override;
+
+
+	/* ---------------- MIXING -------------------*/
+
+	/**
+	 * @brief Mix one block : reads every active channel and kss cartridge, applies the master volume and encodes the result.
+	 * @param it_out output (encoded) buffer - must hold requested_sample_count x channels x bits / 8 bytes
+	 * @param requested_sample_count must be the block size (mixer buffer packet sample size)
+	 */
+	void mix(std::vector<char>::iterator it_out, int requested_sample_count);
+
+	/**
+	 * @tparam N     2 16 bits 3 24 bits
+	 * @param it_out output buffer - encodes the content of the internal mix buffer (last mixed block)
+	 */
+	template <int N>
+	void encode_Nbits(std::vector<char>::iterator it_out);
+
+	/**
+	 * @brief Number of samples of one mixing block
+	 */
+	int get_block_sample_size() const;
+
+	/**
+	 * @brief Mix one block without audio device (caller thread).
+	 *
+	 * @warning Must not be used while an audio stream is running.
+	 *
+	 * @param[out] out receive the encoded block (resized to block size x channels x bits / 8 bytes)
+	 * @return the number of samples rendered - 0 if the format is not set or a stream is running
+	 */
+	int render(std::vector<char> &out);
+};
+
+
+/**
+ * @class MajimixOffline
+ * @brief Headless Majimix : no audio device, the mix is pulled block by block with render().
+ *        Used by the benchmark and load tools, it runs on machines without sound card.
+ */
+class MajimixOffline : public MajimixCore {
+	bool started = false;
+	bool paused = false;
+
+protected:
+	bool is_streaming() const override;
+
+public:
+	MajimixOffline();
+
+	/**
+	 * @brief Decode the Vorbis sources on the worker pool (as the audio backends do).
+	 *        Disabled by default : render() decodes itself, the output is deterministic.
+	 *        Applies to the sources added afterwards.
+	 */
+	void set_decode_ahead(bool enable);
+
+	bool start_stop_mixer(bool start) override;
+	bool pause_resume_mixer(bool pause) override;
+	int get_mixer_status() override;
+};
+
+}
+
+#endif /* MAJIMIX_CORE_HPP_ */
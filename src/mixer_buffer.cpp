@@ -26,6 +26,7 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include "mixer_buffer.hpp"
+#include "profiler.hpp"
 
 namespace majimix 
 {
@@ -113,6 +114,11 @@ void BufferedMixer::start()
 
 	if(!producer_on && mix)
 	{
+#ifdef MAJIMIX_PROFILE
+		// the audio callback records without allocating its ring
+		if(!consumer_ring)
+			consumer_ring = profiler::register_ring("majimix consumer");
+#endif
 		write_position = 0;
 		read_position = 0;
 		read_inrange_index = 0;
@@ -159,6 +165,7 @@ void BufferedMixer::write()
 #ifdef DEBUG
 	std::cout << "BufferedMixer::write() procucer started\n";
 #endif
+	MAJIMIX_PROFILE_THREAD("majimix producer");
 
 	int next;
 	while(producer_on)
@@ -180,8 +187,15 @@ void BufferedMixer::write()
 
 		// check the new writing position and a possible pause
 		// we use a while because of spurious wakeup
+#ifdef MAJIMIX_PROFILE
+		uint64_t wait_begin = profiler::now_ns();
+		bool waited = false;
+#endif
 		while((next == read_position || paused) && producer_on)
 		{
+#ifdef MAJIMIX_PROFILE
+			waited = true;
+#endif
 #ifdef PRODUCERDEBUG
 			if(paused)
 				std::cout << "BufferedMixer::write paused in write_position "<< write_position << "\n";
@@ -194,6 +208,10 @@ void BufferedMixer::write()
 			// unlock 
 			// m.unlock();
 		}
+#ifdef MAJIMIX_PROFILE
+		if(waited)
+			profiler::record(profiler::Stage::producer_wait, wait_begin, profiler::now_ns(), -1);
+#endif
 
 		// next range
 		write_position = next;
@@ -212,6 +230,8 @@ void BufferedMixer::read(char* out_buffer, int requested_sample_count)
 #ifdef CONSUMERDEBUG
 	std::cout << "BufferedMixer::read()\n";
 #endif
+	MAJIMIX_PROFILE_THREAD_RING(consumer_ring, "majimix consumer");
+	MAJIMIX_PROFILE_SCOPE(consumer_read);
 	int out_count = 0;
 	int remaining_out_count = requested_sample_count * sample_size;
 	do
@@ -230,6 +250,7 @@ void BufferedMixer::read(char* out_buffer, int requested_sample_count)
 #ifdef CONSUMERUNDERRUNDEBUG
 			std::cerr << "underrun\n";
 #endif
+			MAJIMIX_PROFILE_INSTANT(underrun);
 
 			std::fill(out_buffer + out_count, out_buffer + out_count + remaining_out_count, (char)0);
 			return;
@@ -38,6 +38,7 @@
 
 namespace majimix 
 {
+namespace profiler { class EventRing; }
 
 /*  ---------- BufferedMixer ----------
  * 
@@ -75,6 +76,9 @@ class BufferedMixer {
 	/** producer thread function : fills buffer whith audio data read from sample */
 	void write();
 
+	/** profiler ring of the consumer (audio callback) - registered by start (MAJIMIX_PROFILE) */
+	profiler::EventRing *consumer_ring = nullptr;
+
 	/** External mixing and encode function */
 	using fn_mix = std::function<void(std::vector<char>::iterator it_out, int requested_sample_count)>;
 	fn_mix mix;
@@ -0,0 +1,247 @@
+/**
+ * @file profiler.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace majimix::profiler {
+
+/* registry of the rings : only locked when a thread records its first event and on export */
+static std::mutex registry_mutex;
+static std::vector<std::shared_ptr<EventRing>> registry;
+static uint32_t next_tid = 1;
+
+static thread_local EventRing *thread_ring = nullptr;
+static thread_local int32_t thread_voice = -1;
+
+static EventRing *get_thread_ring(const char *name = nullptr)
+{
+	if(!thread_ring)
+	{
+		std::lock_guard<std::mutex> lg(registry_mutex);
+		auto ring = std::make_shared<EventRing>(next_tid++, name ? name : "");
+		thread_ring = ring.get();
+		registry.push_back(std::move(ring));
+	}
+	return thread_ring;
+}
+
+const char *stage_name(Stage stage)
+{
+	switch(stage)
+	{
+	case Stage::mix:             return "mix";
+	case Stage::voice:           return "voice";
+	case Stage::vorbis_decode:   return "vorbis_decode";
+	case Stage::vorbis_resample: return "vorbis_resample";
+	case Stage::pcm_resample:    return "pcm_resample";
+	case Stage::wave_read:       return "wave_read";
+	case Stage::wave_resample:   return "wave_resample";
+	case Stage::block_decode:    return "block_decode";
+	case Stage::block_resample:  return "block_resample";
+	case Stage::kss_emulation:   return "kss_emulation";
+	case Stage::accumulate:      return "accumulate";
+	case Stage::encode:          return "encode";
+	case Stage::producer_wait:   return "producer_wait";
+	case Stage::consumer_read:   return "consumer_read";
+	case Stage::underrun:        return "underrun";
+	}
+	return "unknown";
+}
+
+EventRing::EventRing(uint32_t tid, const char *name)
+: tid {tid},
+  name {name},
+  head {0},
+  start {0}
+{}
+
+void EventRing::push(const Event &event)
+{
+	uint64_t h = head.load(std::memory_order_relaxed);
+	Slot &slot = slots[h & (capacity - 1)];
+	// seqlock write : the slot is marked as being written before its content changes
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.begin_ns.store(event.begin_ns, std::memory_order_relaxed);
+	slot.end_ns.store(event.end_ns, std::memory_order_relaxed);
+	slot.voice_stage.store(static_cast<uint64_t>(static_cast<uint32_t>(event.voice)) << 8 | static_cast<uint8_t>(event.stage), std::memory_order_relaxed);
+	slot.sequence.store(h + 1, std::memory_order_release);
+	head.store(h + 1, std::memory_order_release);
+}
+
+bool EventRing::read(uint64_t index, Event &event) const
+{
+	const Slot &slot = slots[index & (capacity - 1)];
+	uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+	if(sequence != index + 1)
+		return false;
+	event.begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+	event.end_ns = slot.end_ns.load(std::memory_order_relaxed);
+	uint64_t voice_stage = slot.voice_stage.load(std::memory_order_relaxed);
+	// the copy is valid if the owner did not start to overwrite the slot meanwhile
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if(slot.sequence.load(std::memory_order_relaxed) != sequence)
+		return false;
+	event.voice = static_cast<int32_t>(static_cast<uint32_t>(voice_stage >> 8));
+	event.stage = static_cast<Stage>(voice_stage & 0xff);
+	return true;
+}
+
+uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int32_t &current_voice()
+{
+	return thread_voice;
+}
+
+void set_thread_name(const char *name)
+{
+	EventRing *ring = get_thread_ring(name);
+	// published ring : the name is read by the export (only this thread writes it)
+	if(ring->name.empty())
+	{
+		std::lock_guard<std::mutex> lg(registry_mutex);
+		ring->name = name;
+	}
+}
+
+EventRing *register_ring(const char *name)
+{
+	std::lock_guard<std::mutex> lg(registry_mutex);
+	auto ring = std::make_shared<EventRing>(next_tid++, name);
+	registry.push_back(ring);
+	return ring.get();
+}
+
+void use_ring(EventRing *ring, const char *name)
+{
+	if(ring)
+		thread_ring = ring;
+	else
+		set_thread_name(name);
+}
+
+void record(Stage stage, uint64_t begin_ns, uint64_t end_ns, int32_t voice)
+{
+	get_thread_ring()->push({begin_ns, end_ns, voice, stage});
+}
+
+void instant(Stage stage)
+{
+	uint64_t t = now_ns();
+	get_thread_ring()->push({t, t, thread_voice, stage});
+}
+
+bool write_chrome_trace(const std::string &filename)
+{
+	std::ofstream os(filename);
+	if(!os)
+		return false;
+
+	std::vector<std::shared_ptr<EventRing>> rings;
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lg(registry_mutex);
+		rings = registry;
+		for(auto &ring : rings)
+			names.push_back(ring->name.empty() ? "thread" : ring->name);
+	}
+
+	// copy the events first : the owners keep recording (the overwritten ones are skipped)
+	std::vector<std::vector<Event>> ring_events(rings.size());
+	for(size_t r = 0; r < rings.size(); ++r)
+	{
+		auto &ring = rings[r];
+		uint64_t h = ring->head.load(std::memory_order_acquire);
+		uint64_t first = std::max(ring->start.load(std::memory_order_acquire), h > EventRing::capacity ? h - EventRing::capacity : 0);
+		Event e;
+		for(uint64_t i = first; i < h; ++i)
+			if(ring->read(i, e))
+				ring_events[r].push_back(e);
+	}
+
+	// timestamps relative to the oldest event (events are pushed when they end, not in begin order)
+	uint64_t origin = UINT64_MAX;
+	for(auto &events : ring_events)
+		for(auto &e : events)
+			origin = std::min(origin, e.begin_ns);
+	if(origin == UINT64_MAX)
+		origin = 0;
+
+	os << std::fixed << std::setprecision(3);
+	os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+	bool first_event = true;
+	auto separator = [&]() -> std::ostream& {
+		if(!first_event)
+			os << ",\n";
+		first_event = false;
+		return os;
+	};
+
+	for(size_t r = 0; r < rings.size(); ++r)
+	{
+		auto &ring = rings[r];
+		separator() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->tid
+		            << ",\"args\":{\"name\":\"" << names[r] << "\"}}";
+
+		for(auto &e : ring_events[r])
+		{
+			double ts = (e.begin_ns - origin) / 1000.;
+			separator() << "{\"name\":\"" << stage_name(e.stage) << "\",\"cat\":\"majimix\",\"pid\":1,\"tid\":" << ring->tid
+			            << ",\"ts\":" << ts;
+			if(e.stage == Stage::underrun)
+				os << ",\"ph\":\"i\",\"s\":\"t\"";
+			else
+				os << ",\"ph\":\"X\",\"dur\":" << (e.end_ns - e.begin_ns) / 1000.;
+			if(e.voice >= 0)
+				os << ",\"args\":{\"voice\":" << e.voice << "}";
+			os << "}";
+		}
+	}
+	os << "\n]}\n";
+	return static_cast<bool>(os);
+}
+
+void clear()
+{
+	// head belongs to the owner : the discarded events are skipped by the export
+	std::lock_guard<std::mutex> lg(registry_mutex);
+	for(auto &ring : registry)
+		ring->start.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+}
@@ -0,0 +1,207 @@
+/**
+ * @file profiler.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * \namespace majimix::profiler
+ * \brief Hot-path instrumentation of the mixer
+ * \details Scoped timestamps are recorded per stage (and per voice) into a fixed size
+ *          ring owned by the recording thread. Only the owning thread writes its ring,
+ *          so recording takes no lock and does not allocate (except once, on the first
+ *          event of a thread - or never : a ring registered by another thread can be
+ *          handed to a real-time thread, as done for the audio callback and MajimixOffline::render).
+ *          The export and clear() can run while the mixer records.
+ *          The rings can be exported in the Chrome trace event format (chrome://tracing, Perfetto).
+ *
+ *          The instrumentation is only compiled when MAJIMIX_PROFILE is defined,
+ *          otherwise the MAJIMIX_PROFILE_* macros expand to nothing.
+ */
+namespace majimix::profiler {
+
+/**
+ * @brief Instrumented stages
+ */
+enum class Stage : uint8_t
+{
+    mix,             /**< a complete mixing block (MajimixPa::mix) */
+    voice,           /**< Sample::read of one mixer channel */
+    vorbis_decode,   /**< ov_read_float */
+    vorbis_resample, /**< SampleVorbis resampling */
+    pcm_resample,    /**< SourcePCMF resampling */
+    wave_read,       /**< SampleWaveStream file read and conversion */
+    wave_resample,   /**< SampleWaveStream resampling */
+    block_decode,    /**< SourceBlock block decoding (ADPCM, QOA) */
+    block_resample,  /**< SampleBlock resampling */
+    kss_emulation,   /**< KSSPLAY_calc of one kss line */
+    accumulate,      /**< sum of the voices into the mix buffer */
+    encode,          /**< master volume and output encoding */
+    producer_wait,   /**< BufferedMixer producer waiting for a free buffer */
+    consumer_read,   /**< BufferedMixer::read (audio callback) */
+    underrun         /**< BufferedMixer::read found no mixed buffer (instant event) */
+};
+
+const char *stage_name(Stage stage);
+
+/**
+ * @brief One recorded event - begin == end for an instant event
+ */
+struct Event
+{
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    int32_t voice;
+    Stage stage;
+};
+
+/**
+ * @brief Single writer ring of events.
+ *        The oldest events are overwritten when the ring is full.
+ *        Each slot carries the index of its event (seqlock) : a reader detects the slots
+ *        overwritten while it copies them and never gets a torn event.
+ */
+class EventRing
+{
+public:
+    constexpr static uint32_t capacity = 1 << 16;
+
+    EventRing(uint32_t tid, const char *name);
+
+    /* owning thread only */
+    void push(const Event &event);
+
+    /**
+     * @brief Copy the event index (any thread)
+     * @return false if the event was overwritten (or is being written) by the owner
+     */
+    bool read(uint64_t index, Event &event) const;
+
+    uint32_t tid;
+    std::string name;
+    /** total number of events pushed */
+    std::atomic<uint64_t> head;
+    /** index of the first event kept by clear() - only written by clear, the owner never resets head */
+    std::atomic<uint64_t> start;
+
+private:
+    struct Slot
+    {
+        /** index + 1 of the stored event - 0 while the owner writes it */
+        std::atomic<uint64_t> sequence {0};
+        std::atomic<uint64_t> begin_ns {0};
+        std::atomic<uint64_t> end_ns {0};
+        /** voice << 8 | stage */
+        std::atomic<uint64_t> voice_stage {0};
+    };
+
+    Slot slots[capacity];
+};
+
+/** monotonic clock in nanoseconds */
+uint64_t now_ns();
+
+/** voice associated with the events of the current thread (-1 : none) */
+int32_t &current_voice();
+
+/** name the current thread in the exported trace (first call wins) */
+void set_thread_name(const char *name);
+
+/**
+ * @brief Allocate and publish a ring for a thread that must not do it itself (audio callback)
+ * @param name thread name in the exported trace
+ * @return the ring - kept until the end of the program
+ */
+EventRing *register_ring(const char *name);
+
+/**
+ * @brief The current thread records on ring (register_ring) : no allocation nor lock.
+ *        Without ring the thread gets its own ring named name.
+ */
+void use_ring(EventRing *ring, const char *name);
+
+/** record a completed event on the ring of the current thread */
+void record(Stage stage, uint64_t begin_ns, uint64_t end_ns, int32_t voice);
+
+/** record an instant event */
+void instant(Stage stage);
+
+/**
+ * @brief Write all the rings to a Chrome trace / Perfetto JSON file.
+ *        Can be called while the mixer runs : the events recorded during the export may
+ *        be missing, and the events overwritten while they are copied are left out.
+ * @param filename output file
+ * @return true if the file was written
+ */
+bool write_chrome_trace(const std::string &filename);
+
+/** discard all the recorded events (the owners keep recording) */
+void clear();
+
+/**
+ * @brief RAII scope - records [construction, destruction] on the current thread
+ */
+class Scope
+{
+    uint64_t begin_ns;
+    int32_t voice;
+    Stage stage;
+
+public:
+    explicit Scope(Stage stage) : begin_ns{now_ns()}, voice{current_voice()}, stage{stage} {}
+    Scope(Stage stage, int32_t voice) : begin_ns{now_ns()}, voice{voice}, stage{stage} {}
+    ~Scope() { record(stage, begin_ns, now_ns(), voice); }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+}
+
+#define MAJIMIX_PROFILE_CONCAT_(a, b) a##b
+#define MAJIMIX_PROFILE_CONCAT(a, b) MAJIMIX_PROFILE_CONCAT_(a, b)
+
+#ifdef MAJIMIX_PROFILE
+#define MAJIMIX_PROFILE_SCOPE(stage) ::majimix::profiler::Scope MAJIMIX_PROFILE_CONCAT(majimix_profile_scope_, __LINE__){::majimix::profiler::Stage::stage}
+#define MAJIMIX_PROFILE_SCOPE_VOICE(stage, voice) ::majimix::profiler::Scope MAJIMIX_PROFILE_CONCAT(majimix_profile_scope_, __LINE__){::majimix::profiler::Stage::stage, static_cast<int32_t>(voice)}
+#define MAJIMIX_PROFILE_INSTANT(stage) ::majimix::profiler::instant(::majimix::profiler::Stage::stage)
+#define MAJIMIX_PROFILE_VOICE(voice) (::majimix::profiler::current_voice() = static_cast<int32_t>(voice))
+#define MAJIMIX_PROFILE_THREAD(name) ::majimix::profiler::set_thread_name(name)
+#define MAJIMIX_PROFILE_THREAD_RING(ring, name) ::majimix::profiler::use_ring(ring, name)
+#else
+#define MAJIMIX_PROFILE_SCOPE(stage) ((void)0)
+#define MAJIMIX_PROFILE_SCOPE_VOICE(stage, voice) ((void)0)
+#define MAJIMIX_PROFILE_INSTANT(stage) ((void)0)
+#define MAJIMIX_PROFILE_VOICE(voice) ((void)0)
+#define MAJIMIX_PROFILE_THREAD(name) ((void)0)
+#define MAJIMIX_PROFILE_THREAD_RING(ring, name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,367 @@
+/**
+ * @file replay.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section replay_desc DESCRIPTION
+ *
+ * majimix_replay : offline replay of an API trace (Majimix::start_api_trace).
+ *
+ * The recorded calls are applied to a headless mixer (MajimixOffline) before the block
+ * they were recorded for, so the rendered output is the one mixed in production.
+ * The tool prints an hash (FNV-1a 64) of the rendered output and the mixing time of
+ * the blocks (optionally every block to a CSV file).
+ *
+ * usage : majimix_replay trace_file [--root dir] [--extra n] [--timings file.csv] [--output file.raw]
+ *
+ *   --root     replace the directory of the recorded source files
+ *   --extra    number of blocks rendered after the last recorded call
+ *   --timings  write the mixing time of each block (block,us)
+ *   --output   write the rendered (raw) audio
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench_common.hpp"
+#include "majimix_core.hpp"
+#include "sound_bank.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+using namespace majimix;
+
+namespace {
+
+struct Options {
+	std::string trace;
+	std::string root;
+	int extra = 0;
+	std::string timings;
+	std::string output;
+};
+
+Options options;
+
+/* FNV-1a 64 */
+class Hash {
+	uint64_t h = 0xcbf29ce484222325ULL;
+public:
+	void update(const std::vector<char> &data)
+	{
+		for(char c : data)
+		{
+			h ^= static_cast<uint8_t>(c);
+			h *= 0x100000001b3ULL;
+		}
+	}
+	uint64_t value() const { return h; }
+};
+
+class Replay {
+	MajimixOffline mixer;
+	std::map<long, int> handles;   // recorded handle -> replayed handle
+	int rate = 44100;
+
+	Hash hash;
+	std::ofstream output;
+	std::vector<double> block_ns;
+	std::vector<char> out;
+	/** index of the next block (recorded numbering) */
+	uint64_t block = 0;
+
+	int handle(const trace::Event &e, size_t i) const
+	{
+		long h = e.int_arg(i);
+		if(!h)
+			return 0;
+		auto it = handles.find(h);
+		if(it != handles.end())
+			return it->second;
+		// play handle : source part (16 bits) + channel or line
+		it = handles.find(h & 0xFFFF);
+		if(it != handles.end())
+			return static_cast<int>((h & ~0xFFFFL) | (it->second & 0xFFFF));
+		return static_cast<int>(h);
+	}
+
+	std::string file(const std::string &name) const
+	{
+		if(options.root.empty())
+			return name;
+		return (std::filesystem::path(options.root) / std::filesystem::path(name).filename()).string();
+	}
+
+	/** add_source, add_source_async and add_bank arguments */
+	static SourceOptions source_options(const trace::Event &e)
+	{
+		SourceOptions source_options;
+		if(e.args.size() > 1)
+			source_options.vorbis_in_memory = e.bool_arg(1);
+		if(e.args.size() > 2)
+			source_options.vorbis_decoders = e.int_arg(2);
+		if(e.args.size() > 4)
+		{
+			source_options.vorbis_decode_max_ms = e.int_arg(3);
+			source_options.vorbis_decode_max_bytes = e.int_arg(4);
+		}
+		if(e.args.size() > 6)
+		{
+			source_options.vorbis_seek_index = e.bool_arg(5);
+			source_options.vorbis_seek_index_file = e.bool_arg(6);
+		}
+		if(e.args.size() > 7)
+			source_options.vorbis_loop_head_ms = e.int_arg(7);
+		if(e.args.size() > 8)
+			source_options.wave_mapped = e.bool_arg(8);
+		if(e.args.size() > 9)
+			source_options.wave_streamed = e.bool_arg(9);
+		if(e.args.size() > 10)
+			source_options.pcm_native = e.bool_arg(10);
+		if(e.args.size() > 11)
+			source_options.shared_data = e.bool_arg(11);
+		if(e.args.size() > 12)
+			source_options.queue_play = e.bool_arg(12);
+		if(e.args.size() > 13)
+			source_options.lazy = e.bool_arg(13);
+		return source_options;
+	}
+
+	void map_result(const trace::Event &e, int result)
+	{
+		if(e.has_result)
+		{
+			handles[e.result] = result;
+			if(result != e.result)
+				std::cerr << "warning : block " << e.block << " " << e.call << " returned " << result << " (recorded " << e.result << ")\n";
+		}
+	}
+
+public:
+	bool open_output(const std::string &filename)
+	{
+		output.open(filename, std::ios::binary);
+		return static_cast<bool>(output);
+	}
+
+	/** the trace begins at block first_block */
+	void set_first_block(uint64_t first_block)
+	{
+		block = first_block;
+	}
+
+	/** render blocks up to (excluded) block last_block */
+	void render_until(uint64_t last_block)
+	{
+		for(; block < last_block; ++block)
+		{
+			bench::Stopwatch sw;
+			if(!mixer.render(out))
+			{
+				// no format : nothing was mixed
+				block = last_block;
+				return;
+			}
+			block_ns.push_back(sw.elapsed_ns());
+			hash.update(out);
+			if(output.is_open())
+				output.write(out.data(), static_cast<std::streamsize>(out.size()));
+		}
+	}
+
+	bool apply(const trace::Event &e)
+	{
+		const std::string &c = e.call;
+		if(c == "set_format")
+		{
+			rate = e.int_arg(0);
+			mixer.set_format(rate, e.bool_arg(1), e.int_arg(2), e.int_arg(3));
+		}
+		else if(c == "set_mixer_buffer_parameters")
+			mixer.set_mixer_buffer_parameters(e.int_arg(0), e.int_arg(1));
+		else if(c == "set_master_volume")
+			mixer.set_master_volume(e.int_arg(0));
+		else if(c == "add_source")
+			map_result(e, mixer.add_source(file(e.args.at(0)), source_options(e)));
+		else if(c == "add_source_async")
+		{
+			// loaded before the next block : the recorded loading time can't be reproduced
+			int h = mixer.add_source_async(file(e.args.at(0)), source_options(e));
+			mixer.wait_source(h);
+			map_result(e, h);
+		}
+		else if(c == "add_bank")
+		{
+			// the recorded handles are in the order of the bank directory (0 : asset not loaded)
+			std::string bank_file = file(e.args.at(0));
+			auto replayed = mixer.add_bank(bank_file, source_options(e));
+			std::istringstream recorded(e.args.at(14));
+			SoundBank bank;
+			if(bank.open(bank_file))
+			{
+				for(size_t i = 0; i < bank.size(); ++i)
+				{
+					long h = 0;
+					recorded >> h;
+					auto it = replayed.find(std::string(bank.name(bank.entry(i))));
+					if(it == replayed.end())
+						continue;
+					if(h)
+						handles[h] = it->second;
+					else
+						mixer.drop_source(it->second);
+				}
+			}
+		}
+		else if(c == "get_source_status")
+			mixer.get_source_status(handle(e, 0));
+		else if(c == "wait_source")
+			mixer.wait_source(handle(e, 0), e.int_arg(1));
+		else if(c == "prefetch_source")
+			mixer.prefetch_source(handle(e, 0));
+		else if(c == "set_memory_budget")
+			mixer.set_memory_budget(static_cast<size_t>(std::stoull(e.args.at(0))));
+		else if(c == "add_source_kss")
+			map_result(e, mixer.add_source_kss(file(e.args.at(0)), e.int_arg(1), e.int_arg(2)));
+		else if(c == "drop_source")
+			mixer.drop_source(handle(e, 0));
+		else if(c == "play_source")
+		{
+			map_result(e, mixer.play_source(handle(e, 0), e.bool_arg(1), e.bool_arg(2)));
+			// unloaded sources : loaded before the next block
+			mixer.wait_source(0);
+		}
+		else if(c == "play_kss_track")
+			map_result(e, mixer.play_kss_track(handle(e, 0), e.int_arg(1), e.bool_arg(2), e.bool_arg(3), e.bool_arg(4)));
+		else if(c == "update_kss_track")
+			mixer.update_kss_track(handle(e, 0), e.int_arg(1), e.bool_arg(2), e.bool_arg(3), e.int_arg(4));
+		else if(c == "stop_playback")
+			mixer.stop_playback(handle(e, 0));
+		else if(c == "pause_resume_playback")
+			mixer.pause_resume_playback(handle(e, 0), e.bool_arg(1));
+		else if(c == "set_loop")
+			mixer.set_loop(handle(e, 0), e.bool_arg(1));
+		else if(c == "update_kss_volume")
+			mixer.update_kss_volume(handle(e, 0), e.int_arg(1));
+		else if(c == "update_kss_frequency")
+			mixer.update_kss_frequency(handle(e, 0), e.int_arg(1));
+		else if(c != "end")
+		{
+			std::cerr << "unknown call " << c << " (block " << e.block << ")\n";
+			return false;
+		}
+		return true;
+	}
+
+	void report()
+	{
+		std::printf("blocks   : %zu\n", block_ns.size());
+		std::printf("hash     : %016llx\n", static_cast<unsigned long long>(hash.value()));
+		if(block_ns.empty())
+			return;
+
+		std::vector<double> sorted(block_ns);
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0;
+		for(double ns : sorted)
+			total += ns;
+		auto pct = [&sorted](double p) { return sorted[static_cast<size_t>(p / 100. * (sorted.size() - 1) + .5)] / 1000.; };
+		const int block_size = mixer.get_block_sample_size();
+		std::printf("block    : %d frames - budget %.1f us\n", block_size, 1e6 * block_size / rate);
+		std::printf("time us  : avg %.1f  p50 %.1f  p99 %.1f  max %.1f\n", total / sorted.size() / 1000., pct(50), pct(99), pct(100));
+
+		if(!options.timings.empty())
+		{
+			std::ofstream os(options.timings);
+			os << "block,us\n";
+			for(size_t i = 0; i < block_ns.size(); ++i)
+				os << i << ',' << block_ns[i] / 1000. << '\n';
+		}
+	}
+};
+
+void usage()
+{
+	std::cout << "usage : majimix_replay trace_file [--root dir] [--extra n] [--timings file.csv] [--output file.raw]\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--root" && has_value)
+			options.root = argv[++i];
+		else if(arg == "--extra" && has_value)
+			options.extra = std::max(0, std::atoi(argv[++i]));
+		else if(arg == "--timings" && has_value)
+			options.timings = argv[++i];
+		else if(arg == "--output" && has_value)
+			options.output = argv[++i];
+		else if(arg[0] != '-' && options.trace.empty())
+			options.trace = arg;
+		else
+		{
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+	if(options.trace.empty())
+	{
+		usage();
+		return 1;
+	}
+
+	std::vector<trace::Event> events;
+	if(!trace::load_trace(options.trace, events))
+	{
+		std::cerr << "cannot read trace " << options.trace << "\n";
+		return 1;
+	}
+
+	Replay replay;
+	if(!options.output.empty() && !replay.open_output(options.output))
+	{
+		std::cerr << "cannot write " << options.output << "\n";
+		return 1;
+	}
+
+	uint64_t last_block = events.empty() ? 0 : events.front().block;
+	replay.set_first_block(last_block);
+	for(auto &e : events)
+	{
+		replay.render_until(e.block);
+		replay.apply(e);
+		last_block = e.block;
+	}
+	replay.render_until(last_block + options.extra);
+
+	std::printf("events   : %zu\n", events.size());
+	replay.report();
+	return 0;
+}
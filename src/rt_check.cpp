@@ -0,0 +1,298 @@
+/**
+ * @file rt_check.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "rt_check.hpp"
+#include <atomic>
+
+#ifdef MAJIMIX_RT_CHECK
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+namespace majimix::rt_check {
+
+static std::atomic<uint64_t> violations {0};
+
+#ifdef MAJIMIX_RT_CHECK
+
+/* POD thread locals : no initialization wrapper, usable from the hooks */
+static thread_local int rt_depth = 0;
+static thread_local bool reporting = false;
+
+using fn_write = ssize_t (*)(int, const void *, size_t);
+
+static fn_write real_write()
+{
+	static fn_write fn = reinterpret_cast<fn_write>(dlsym(RTLD_NEXT, "write"));
+	return fn;
+}
+
+static void print(const char *text)
+{
+	real_write()(STDERR_FILENO, text, std::strlen(text));
+}
+
+bool enabled()
+{
+	return true;
+}
+
+void enter()
+{
+	if(!rt_depth)
+	{
+		// first use of backtrace loads libgcc : do it outside of the real-time section
+		static bool backtrace_loaded = [] {
+			void *frames[1];
+			backtrace(frames, 1);
+			return true;
+		}();
+		(void)backtrace_loaded;
+	}
+	++rt_depth;
+}
+
+void leave()
+{
+	--rt_depth;
+}
+
+void violation(const char *what)
+{
+	if(rt_depth <= 0 || reporting)
+		return;
+	reporting = true;
+	violations.fetch_add(1, std::memory_order_relaxed);
+
+	print("majimix rt_check : ");
+	print(what);
+	print(" called from the mixing thread\n");
+	void *frames[32];
+	int n = backtrace(frames, 32);
+	// skip violation() and the hook
+	if(n > 2)
+		backtrace_symbols_fd(frames + 2, n - 2, STDERR_FILENO);
+	print("\n");
+	reporting = false;
+}
+
+#else
+
+bool enabled()
+{
+	return false;
+}
+
+void enter() {}
+void leave() {}
+void violation(const char *) {}
+
+#endif
+
+uint64_t violation_count()
+{
+	return violations.load(std::memory_order_relaxed);
+}
+
+void reset()
+{
+	violations.store(0, std::memory_order_relaxed);
+}
+
+}
+
+
+#ifdef MAJIMIX_RT_CHECK
+
+using majimix::rt_check::violation;
+
+/* ---------------- allocator ---------------- */
+
+static void *checked_alloc(std::size_t size, const char *what)
+{
+	violation(what);
+	void *p = std::malloc(size ? size : 1);
+	return p;
+}
+
+static void *checked_aligned_alloc(std::size_t size, std::align_val_t al, const char *what)
+{
+	violation(what);
+	std::size_t alignment = static_cast<std::size_t>(al);
+	std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+	return std::aligned_alloc(alignment, rounded ? rounded : alignment);
+}
+
+static void checked_free(void *p)
+{
+	if(p)
+		violation("operator delete");
+	std::free(p);
+}
+
+void *operator new(std::size_t size)
+{
+	if(void *p = checked_alloc(size, "operator new"))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+	if(void *p = checked_alloc(size, "operator new[]"))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	return checked_alloc(size, "operator new");
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	return checked_alloc(size, "operator new[]");
+}
+
+void *operator new(std::size_t size, std::align_val_t al)
+{
+	if(void *p = checked_aligned_alloc(size, al, "operator new"))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t al)
+{
+	if(void *p = checked_aligned_alloc(size, al, "operator new[]"))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { checked_free(p); }
+void operator delete[](void *p) noexcept { checked_free(p); }
+void operator delete(void *p, std::size_t) noexcept { checked_free(p); }
+void operator delete[](void *p, std::size_t) noexcept { checked_free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { checked_free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { checked_free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { checked_free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { checked_free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { checked_free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { checked_free(p); }
+
+
+/* ---------------- blocking functions ---------------- */
+
+template<typename F>
+static F real(const char *name)
+{
+	return reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+}
+
+extern "C" {
+
+int open(const char *path, int flags, ...)
+{
+	static auto fn = real<int (*)(const char *, int, ...)>("open");
+	violation("open");
+	mode_t mode = 0;
+	if(flags & (O_CREAT | O_TMPFILE))
+	{
+		va_list args;
+		va_start(args, flags);
+		mode = static_cast<mode_t>(va_arg(args, int));
+		va_end(args);
+	}
+	return fn(path, flags, mode);
+}
+
+FILE *fopen(const char *path, const char *mode)
+{
+	static auto fn = real<FILE *(*)(const char *, const char *)>("fopen");
+	violation("fopen");
+	return fn(path, mode);
+}
+
+FILE *fopen64(const char *path, const char *mode)
+{
+	static auto fn = real<FILE *(*)(const char *, const char *)>("fopen64");
+	violation("fopen");
+	return fn(path, mode);
+}
+
+ssize_t read(int fd, void *buf, size_t count)
+{
+	static auto fn = real<ssize_t (*)(int, void *, size_t)>("read");
+	violation("read");
+	return fn(fd, buf, count);
+}
+
+ssize_t write(int fd, const void *buf, size_t count)
+{
+	violation("write");
+	return majimix::rt_check::real_write()(fd, buf, count);
+}
+
+size_t fwrite(const void *ptr, size_t size, size_t n, FILE *stream)
+{
+	static auto fn = real<size_t (*)(const void *, size_t, size_t, FILE *)>("fwrite");
+	violation("fwrite");
+	return fn(ptr, size, n, stream);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept
+{
+	static auto fn = real<int (*)(pthread_mutex_t *)>("pthread_mutex_lock");
+	violation("pthread_mutex_lock");
+	return fn(mutex);
+}
+
+/* std::condition_variable::notify_one / notify_all : system call when a thread waits */
+int pthread_cond_signal(pthread_cond_t *cond) noexcept
+{
+	static auto fn = real<int (*)(pthread_cond_t *)>("pthread_cond_signal");
+	violation("pthread_cond_signal");
+	return fn(cond);
+}
+
+int pthread_cond_broadcast(pthread_cond_t *cond) noexcept
+{
+	static auto fn = real<int (*)(pthread_cond_t *)>("pthread_cond_broadcast");
+	violation("pthread_cond_broadcast");
+	return fn(cond);
+}
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * @file rt_check.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef RT_CHECK_HPP_
+#define RT_CHECK_HPP_
+
+#include <cstdint>
+
+/**
+ * \namespace majimix::rt_check
+ * \brief Real-time safety checker of the mixing thread (debug mode)
+ * \details When majimix is built with MAJIMIX_RT_CHECK, the global operator new / delete
+ *          and some blocking functions (open, fopen, read, write, fwrite, pthread_mutex_lock,
+ *          pthread_cond_signal, pthread_cond_broadcast) are hooked. Each call made while a thread is inside MajimixCore::mix is reported
+ *          on stderr with a stack trace (glibc backtrace) and counted.
+ *
+ *          The hooks replace the functions of the whole process : this mode is only meant
+ *          for debugging and testing (majimix_stress --rt-check).
+ */
+namespace majimix::rt_check {
+
+/** true if the checker is compiled in */
+bool enabled();
+
+/** the current thread enters / leaves the real-time section */
+void enter();
+void leave();
+
+/** report a violation if the current thread is in the real-time section */
+void violation(const char *what);
+
+/** number of violations reported since the last reset */
+uint64_t violation_count();
+void reset();
+
+/**
+ * @brief RAII real-time section
+ */
+class Scope
+{
+public:
+	Scope() { enter(); }
+	~Scope() { leave(); }
+	Scope(const Scope &) = delete;
+	Scope &operator=(const Scope &) = delete;
+};
+
+}
+
+#ifdef MAJIMIX_RT_CHECK
+#define MAJIMIX_RT_SECTION() ::majimix::rt_check::Scope majimix_rt_check_scope
+#else
+#define MAJIMIX_RT_SECTION() ((void)0)
+#endif
+
+#endif
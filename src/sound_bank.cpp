@@ -0,0 +1,163 @@
+/**
+ * @file sound_bank.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "sound_bank.hpp"
+#include "wave.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+namespace majimix {
+
+static uint64_t align(uint64_t offset)
+{
+	return (offset + bank::alignment - 1) / bank::alignment * bank::alignment;
+}
+
+bool SoundBank::open(const std::string &filename)
+{
+	header = nullptr;
+	entries = nullptr;
+	file.reset();
+
+	// the structures are read in place
+	if(!wave::little_endian)
+		return false;
+
+	auto mapped = std::make_shared<MappedFile>();
+	if(!mapped->open(filename) || mapped->size() < sizeof(bank::Header))
+		return false;
+
+	auto h = reinterpret_cast<const bank::Header *>(mapped->data());
+	const uint64_t size = mapped->size();
+	if(std::memcmp(h->magic, bank::magic, sizeof(bank::magic)) || h->version != bank::version
+	   || h->directory_offset % alignof(bank::Entry) || h->directory_offset > size
+	   || (size - h->directory_offset) / sizeof(bank::Entry) < h->entry_count
+	   || h->names_offset > size || size - h->names_offset < h->names_size)
+	{
+#ifdef DEBUG
+		std::cerr << filename << " : not a sound bank\n";
+#endif
+		return false;
+	}
+
+	auto e = reinterpret_cast<const bank::Entry *>(mapped->data() + h->directory_offset);
+	for(uint32_t i = 0; i < h->entry_count; ++i)
+	{
+		if(e[i].data_offset > size || size - e[i].data_offset < e[i].data_size
+		   || e[i].name_offset > h->names_size || h->names_size - e[i].name_offset < e[i].name_size)
+		{
+#ifdef DEBUG
+			std::cerr << filename << " : entry " << i << " out of the bank\n";
+#endif
+			return false;
+		}
+	}
+
+	header = h;
+	entries = e;
+	file = std::move(mapped);
+	return true;
+}
+
+std::string_view SoundBank::name(const bank::Entry &entry) const
+{
+	return {file->data() + header->names_offset + entry.name_offset, entry.name_size};
+}
+
+std::shared_ptr<const char> SoundBank::data(const bank::Entry &entry) const
+{
+	return {file, file->data() + entry.data_offset};
+}
+
+bool SoundBank::write(const std::string &filename, std::vector<Asset> assets)
+{
+	if(!wave::little_endian)
+		return false;
+
+	std::sort(assets.begin(), assets.end(), [](const Asset &a, const Asset &b) { return a.name < b.name; });
+	if(std::adjacent_find(assets.begin(), assets.end(), [](const Asset &a, const Asset &b) { return a.name == b.name; }) != assets.end())
+		return false;
+
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if(!out)
+		return false;
+
+	auto pad_to = [&out](uint64_t offset) {
+		static const char zeros[bank::alignment] {};
+		auto position = static_cast<uint64_t>(out.tellp());
+		out.write(zeros, static_cast<std::streamsize>(offset - position));
+	};
+
+	// assets data
+	std::vector<bank::Entry> directory;
+	std::string names;
+	uint64_t offset = align(sizeof(bank::Header));
+	out.seekp(static_cast<std::streamoff>(sizeof(bank::Header)));
+	for(auto &asset : assets)
+	{
+		pad_to(offset);
+		out.write(asset.data.data(), static_cast<std::streamsize>(asset.data.size()));
+
+		bank::Entry entry {};
+		entry.data_offset  = offset;
+		entry.data_size    = asset.data.size();
+		entry.name_offset  = static_cast<uint32_t>(names.size());
+		entry.name_size    = static_cast<uint32_t>(asset.name.size());
+		entry.kind         = static_cast<uint32_t>(asset.kind);
+		entry.format       = asset.format;
+		entry.rate         = asset.rate;
+		entry.channels     = asset.channels;
+		entry.channel_size = asset.channel_size;
+		entry.loop_start   = asset.loop_start;
+		entry.loop_end     = asset.loop_end;
+		directory.push_back(entry);
+		names += asset.name;
+		offset = align(offset + asset.data.size());
+	}
+
+	// directory and names
+	bank::Header header {};
+	std::memcpy(header.magic, bank::magic, sizeof(bank::magic));
+	header.version          = bank::version;
+	header.entry_count      = static_cast<uint32_t>(directory.size());
+	header.directory_offset = offset;
+	header.names_offset     = offset + directory.size() * sizeof(bank::Entry);
+	header.names_size       = names.size();
+	pad_to(offset);
+	out.write(reinterpret_cast<const char *>(directory.data()), static_cast<std::streamsize>(directory.size() * sizeof(bank::Entry)));
+	out.write(names.data(), static_cast<std::streamsize>(names.size()));
+	out.seekp(0);
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	return static_cast<bool>(out);
+}
+
+}
@@ -0,0 +1,142 @@
+/**
+ * @file sound_bank.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SOUND_BANK_HPP_
+#define SOUND_BANK_HPP_
+
+#include "mapped_file.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace majimix {
+
+/**
+ * \namespace majimix::bank
+ * \brief Sound bank file format (little-endian)
+ * \details A bank packs many assets in one file, played from a memory mapping :
+ *          \code
+ *          Header      64 bytes, offset 0
+ *          assets      data of each asset, aligned on 64 bytes
+ *          directory   entry_count x Entry, aligned on 64 bytes
+ *          names       asset names (not terminated), sorted
+ *          \endcode
+ *          The directory is read in place from the mapping : opening a bank does not read
+ *          nor copy the assets.
+ */
+namespace bank {
+
+constexpr char magic[8] = {'M', 'J', 'X', 'B', 'A', 'N', 'K', '1'};
+constexpr uint32_t version = 1;
+/** alignment of the assets data and of the directory */
+constexpr uint64_t alignment = 64;
+
+enum class Kind : uint32_t {
+	pcm    = 0, /**< interleaved PCM samples (AuFormat) - played from the mapping */
+	vorbis = 1  /**< Ogg Vorbis file - decoded from the mapping */
+};
+
+struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t entry_count;
+	uint64_t directory_offset;
+	uint64_t names_offset;
+	uint64_t names_size;
+	uint8_t reserved[24];
+};
+static_assert(sizeof(Header) == 64, "bank::Header layout");
+
+struct Entry {
+	uint64_t data_offset;
+	uint64_t data_size;
+	/** name position in the names block */
+	uint32_t name_offset;
+	uint32_t name_size;
+	/** Kind */
+	uint32_t kind;
+	/** pcm : AuFormat of the samples */
+	uint32_t format;
+	/** pcm : sample rate, channels and bytes per channel */
+	uint32_t rate;
+	uint16_t channels;
+	uint16_t channel_size;
+	/** pcm : loop points (samples) [loop_start, loop_end) - loop_end = 0 : no loop points */
+	uint32_t loop_start;
+	uint32_t loop_end;
+};
+static_assert(sizeof(Entry) == 48, "bank::Entry layout");
+
+}
+
+/**
+ * @class SoundBank
+ * @brief A sound bank mapped in memory.
+ *
+ * The assets point into the mapping : the sources created from a bank keep it mapped.
+ */
+class SoundBank
+{
+	std::shared_ptr<const MappedFile> file;
+	const bank::Header *header = nullptr;
+	const bank::Entry *entries = nullptr;
+
+public:
+	/** an asset to write in a bank */
+	struct Asset {
+		std::string name;
+		bank::Kind kind;
+		/** pcm : see bank::Entry */
+		uint32_t format = 0;
+		uint32_t rate = 0;
+		uint16_t channels = 0;
+		uint16_t channel_size = 0;
+		uint32_t loop_start = 0;
+		uint32_t loop_end = 0;
+		std::vector<char> data;
+	};
+
+	/** map a bank and check its directory - false : not a bank, or a corrupted one */
+	bool open(const std::string &filename);
+
+	size_t size() const { return header ? header->entry_count : 0; }
+	const bank::Entry &entry(size_t i) const { return entries[i]; }
+	/** name of an entry (in the mapping) */
+	std::string_view name(const bank::Entry &entry) const;
+	/** data of an entry (in the mapping - keeps it mapped) */
+	std::shared_ptr<const char> data(const bank::Entry &entry) const;
+	const std::shared_ptr<const MappedFile> &mapping() const { return file; }
+
+	/** write a bank (the assets are sorted by name, the names must be unique) */
+	static bool write(const std::string &filename, std::vector<Asset> assets);
+};
+
+}
+
+#endif
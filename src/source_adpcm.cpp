@@ -0,0 +1,259 @@
+/**
+ * @file source_adpcm.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "source_adpcm.hpp"
+#include "wave.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <climits>
+#include <fstream>
+
+namespace majimix {
+
+/* ---------------------- decoders ----------------------------- */
+
+static const int32_t ima_steps[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int ima_index_steps[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+static const int32_t ms_adaptation[16] = {230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230};
+
+static const int32_t ms_default_coefficients[14] = {256, 0, 512, -256, 0, 0, 192, 64, 240, 0, 460, -208, 392, -232};
+
+static int16_t read_i16(const unsigned char *p)
+{
+	return static_cast<int16_t>(p[0] | p[1] << 8);
+}
+
+/* one IMA nibble : without branch (the bits of the code select the step fractions) */
+static inline int32_t ima_expand(int32_t &predictor, int &index, unsigned int code)
+{
+	const int32_t step = ima_steps[index];
+	int32_t diff = (step >> 3) + (step & -static_cast<int32_t>((code >> 2) & 1))
+	             + ((step >> 1) & -static_cast<int32_t>((code >> 1) & 1)) + ((step >> 2) & -static_cast<int32_t>(code & 1));
+	diff = (code & 8) ? -diff : diff;
+	predictor = std::clamp(predictor + diff, -32768, 32767);
+	index = std::clamp(index + ima_index_steps[code], 0, 88);
+	return predictor;
+}
+
+void SourceADPCM::decode_ima(const unsigned char *in, int frames, int shift, int32_t *out) const
+{
+	// header (predictor, step index) of each channel, then 4 bytes (8 nibbles, low first) per channel in turn :
+	// the channels are decoded independently, one after the other
+	const unsigned char *nibbles = in + 4 * channels;
+	for(int c = 0; c < channels; ++c)
+	{
+		int32_t predictor = read_i16(in + 4 * c);
+		int index = std::min<int>(in[4 * c + 2], 88);
+		int32_t *o = out + c;
+		*o = predictor * (1 << shift);
+		o += channels;
+
+		const unsigned char *p = nibbles + 4 * c;
+		for(int i = 1; i < frames; p += 4 * channels)
+		{
+			for(int b = 0; b < 4 && i < frames; ++b)
+			{
+				*o = ima_expand(predictor, index, p[b] & 0x0F) * (1 << shift);
+				o += channels;
+				if(++i < frames)
+				{
+					*o = ima_expand(predictor, index, p[b] >> 4) * (1 << shift);
+					o += channels;
+					++i;
+				}
+			}
+		}
+	}
+}
+
+void SourceADPCM::decode_ms(const unsigned char *in, int frames, int shift, int32_t *out) const
+{
+	// header : predictor of each channel, then delta, sample 1 and sample 2 (the first frames : sample 2, sample 1)
+	struct State {
+		int32_t coefficient_1, coefficient_2, delta, sample_1, sample_2;
+	};
+	std::array<State, 8> states;
+	const int coefficient_count = static_cast<int>(coefficients.size() / 2);
+	for(int c = 0; c < channels; ++c)
+	{
+		int predictor = std::min<int>(in[c], coefficient_count - 1);
+		states[c] = {coefficients[2 * predictor], coefficients[2 * predictor + 1], read_i16(in + channels + 2 * c),
+		             read_i16(in + 3 * channels + 2 * c), read_i16(in + 5 * channels + 2 * c)};
+		out[c] = states[c].sample_2 * (1 << shift);
+		if(frames > 1)
+			out[channels + c] = states[c].sample_1 * (1 << shift);
+	}
+
+	// nibbles (high first) of the channels in turn
+	const unsigned char *p = in + 7 * channels;
+	const int values = std::max(frames - 2, 0) * channels;
+	int32_t *o = out + 2 * channels;
+	for(int i = 0; i < values; ++i)
+	{
+		State &s = states[i % channels];
+		int code = (i & 1) ? p[i >> 1] & 0x0F : p[i >> 1] >> 4;
+		int32_t prediction = (s.sample_1 * s.coefficient_1 + s.sample_2 * s.coefficient_2) >> 8;
+		int32_t sample = std::clamp(prediction + (code - ((code & 8) << 1)) * s.delta, -32768, 32767);
+		s.sample_2 = s.sample_1;
+		s.sample_1 = sample;
+		s.delta = std::max((ms_adaptation[code] * s.delta) >> 8, 16);
+		*o++ = sample * (1 << shift);
+	}
+}
+
+
+/* ---------------------- SourceADPCM ----------------------------- */
+
+bool SourceADPCM::load_wave(const std::string &filename, bool mapped)
+{
+	// the headers first : the other formats are not loaded
+	wave::pcm_data pcm_data;
+	if(!wave::load_wave(filename, pcm_data, false))
+		return false;
+	return load_wave(filename, pcm_data, mapped);
+}
+
+bool SourceADPCM::load_wave(const std::string &filename, wave::pcm_data &pcm_data, bool mapped)
+{
+	const wave::fmt_base &fmt = pcm_data.fmt;
+	const auto wformat = wave::get_wave_format(fmt.wFormatTag);
+	if(wformat != wave::WAVE_FORMAT::WAVE_FORMAT_IMA_ADPCM && wformat != wave::WAVE_FORMAT::WAVE_FORMAT_ADPCM)
+		return false;
+	const Codec codec = wformat == wave::WAVE_FORMAT::WAVE_FORMAT_IMA_ADPCM ? Codec::ima : Codec::ms;
+	const int header_size = (codec == Codec::ima ? 4 : 7) * fmt.nChannels;
+	if(!fmt.nChannels || fmt.nChannels > 8 || !fmt.nSamplesPerSec || fmt.nBlockAlign <= header_size
+	   || pcm_data.data_size > static_cast<uint64_t>(INT32_MAX))
+		return false;
+
+	// frames of a block : the header frame(s), then 2 frames per byte and channel
+	// IMA : the nibbles are in groups of 4 bytes per channel (8 frames), a partial group is not decoded
+	// (short last block : decode_ima reads whole groups)
+	auto frames_of = [&](uint64_t bytes) -> int64_t {
+		if(bytes < static_cast<uint64_t>(header_size))
+			return 0;
+		if(codec == Codec::ima)
+			return static_cast<int64_t>((bytes - header_size) / (4 * fmt.nChannels) * 8) + 1;
+		return static_cast<int64_t>((bytes - header_size) * 2 / fmt.nChannels) + 2;
+	};
+	const int64_t full_frames = frames_of(fmt.nBlockAlign);
+	const int frames = fmt.wSamplesPerBlock ? std::min<int>(fmt.wSamplesPerBlock, static_cast<int>(full_frames)) : static_cast<int>(full_frames);
+	const uint64_t blocks = pcm_data.data_size / fmt.nBlockAlign;
+	int64_t total = static_cast<int64_t>(blocks) * frames + std::min<int64_t>(frames_of(pcm_data.data_size % fmt.nBlockAlign), frames);
+	if(fmt.dwSampleLength)
+		total = std::min<int64_t>(total, fmt.dwSampleLength);
+	if(total <= 0 || total > INT32_MAX)
+		return false;
+
+	AssetCache::Data bytes;
+	if(mapped)
+	{
+		// the data chunk must be in the file (truncated file : the access would fault)
+		auto file = std::make_shared<MappedFile>();
+		if(!file->open(filename) || pcm_data.data_offset + pcm_data.data_size > file->size())
+			return false;
+		bytes = std::make_shared<const Blob>(std::move(file), pcm_data.data_offset, static_cast<size_t>(pcm_data.data_size));
+	}
+	else if(!shared && pcm_data.data.size() == pcm_data.data_size)
+		bytes = std::make_shared<const Blob>(std::move(pcm_data.data));
+	else
+	{
+		// data chunk not read with the headers
+		const uint64_t offset = pcm_data.data_offset;
+		const size_t length = static_cast<size_t>(pcm_data.data_size);
+		auto load = [&](std::vector<char> &data) {
+			std::ifstream stream(filename, std::ios::binary);
+			data.resize(length);
+			stream.seekg(static_cast<std::streamoff>(offset));
+			stream.read(data.data(), static_cast<std::streamsize>(length));
+			return static_cast<bool>(stream);
+		};
+		bytes = shared ? AssetCache::instance().get(filename, AssetCache::Content::wave_data, load) : AssetCache::load(load);
+	}
+	if(!bytes)
+		return false;
+
+	this->filename = filename;
+	this->codec    = codec;
+	data           = std::move(bytes);
+	sample_rate    = fmt.nSamplesPerSec;
+	channels       = fmt.nChannels;
+	block_size     = fmt.nBlockAlign;
+	block_frames   = frames;
+	size           = static_cast<int32_t>(total);
+	coefficients.clear();
+	if(codec == Codec::ms)
+	{
+		if(fmt.coefficients.size() >= 2)
+			coefficients.assign(fmt.coefficients.begin(), fmt.coefficients.end());
+		else
+			coefficients.assign(std::begin(ms_default_coefficients), std::end(ms_default_coefficients));
+	}
+	loop_start = 0;
+	loop_end   = 0;
+	if(pcm_data.loop_end && pcm_data.loop_start < pcm_data.loop_end && pcm_data.loop_end <= static_cast<uint32_t>(size))
+	{
+		loop_start = static_cast<int32_t>(pcm_data.loop_start);
+		loop_end   = static_cast<int32_t>(pcm_data.loop_end);
+	}
+#ifdef DEBUG
+	std::cout << filename << " : " << (codec == Codec::ima ? "IMA" : "MS") << " ADPCM, " << size << " frames, blocks of "
+	          << block_frames << " frames (" << block_size << " bytes)\n";
+#endif
+	return true;
+}
+
+void SourceADPCM::set_shared(bool enable)
+{
+	shared = enable;
+}
+
+void SourceADPCM::decode_block(int32_t block, int32_t *out, DecoderState &) const
+{
+	// the ADPCM blocks are independent
+	const auto *in = reinterpret_cast<const unsigned char *>(data->data()) + static_cast<size_t>(block) * block_size;
+	const int shift = mixer_bits == 24 ? 8 : 0;
+	if(codec == Codec::ima)
+		decode_ima(in, frames_in_block(block), shift, out);
+	else
+		decode_ms(in, frames_in_block(block), shift, out);
+}
+
+size_t SourceADPCM::memory_size() const
+{
+	// the mapped data is in the page cache
+	return data && !data->mapped() ? data->size() : 0;
+}
+
+}
@@ -0,0 +1,89 @@
+/**
+ * @file source_adpcm.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SOURCE_ADPCM_HPP_
+#define SOURCE_ADPCM_HPP_
+
+#include "source_block.hpp"
+#include "asset_cache.hpp"
+#include <string>
+#include <vector>
+
+namespace majimix 
+{
+
+namespace wave { struct pcm_data; }
+
+/**
+ * @class SourceADPCM
+ * @brief IMA / Microsoft ADPCM WAVE file : the compressed blocks (4 bits per sample) are kept
+ *        in memory and decoded by the samples, one block at a time, while they are resampled.
+ */
+class SourceADPCM : public SourceBlock
+{
+public:
+    enum class Codec { ima, ms };
+
+private:
+    std::string filename;
+    Codec codec = Codec::ima;
+
+    /** data chunk (the blocks) - shared with the other sources of the same file */
+    AssetCache::Data data;
+    /** the data is loaded through the AssetCache */
+    bool shared = false;
+
+    /** size of a block (all channels) */
+    int block_size = 0;
+    /** MS ADPCM predictor coefficients (pairs) */
+    std::vector<int32_t> coefficients;
+
+    void decode_ima(const unsigned char *in, int frames, int shift, int32_t *out) const;
+    void decode_ms(const unsigned char *in, int frames, int shift, int32_t *out) const;
+
+public:
+    /**
+     * @brief Load an IMA ADPCM (0x0011) or MS ADPCM (0x0002) WAVE file
+     * @param mapped the data is played from the mapped file (see SourcePCM::load_wave)
+     * @return false if the file is not an ADPCM WAVE file
+     */
+    bool load_wave(const std::string &filename, bool mapped = false);
+    /**
+     * @brief Load an ADPCM WAVE file whose headers are already read
+     * @param pcm_data headers (wave::load_wave) - the data chunk is read if it was not loaded with them
+     */
+    bool load_wave(const std::string &filename, wave::pcm_data &pcm_data, bool mapped = false);
+    /** the data is shared (AssetCache) - call before load_wave */
+    void set_shared(bool enable);
+
+    void decode_block(int32_t block, int32_t *out, DecoderState &state) const override;
+    size_t memory_size() const override;
+};
+
+}
+
+#endif
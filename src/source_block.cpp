@@ -0,0 +1,236 @@
+/**
+ * @file source_block.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "source_block.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+
+namespace majimix {
+
+/* ---------------------- SourceBlock ----------------------------- */
+
+int SourceBlock::frames_in_block(int32_t block) const
+{
+	return static_cast<int>(std::min<int64_t>(block_frames, size - static_cast<int64_t>(block) * block_frames));
+}
+
+void SourceBlock::set_output_format(int samples_per_sec, int channels, int bits)
+{
+	mixer_rate = samples_per_sec;
+	mixer_channels = channels;
+	mixer_bits = bits;
+}
+
+bool SourceBlock::get_loop_points(int64_t &start, int64_t &end) const
+{
+	if(!loop_end)
+		return false;
+	start = loop_start;
+	end = loop_end;
+	return true;
+}
+
+std::unique_ptr<Sample> SourceBlock::create_sample(bool loop)
+{
+	if(!size || mixer_rate <= 0 || (mixer_bits != 16 && mixer_bits != 24) || (mixer_channels != 1 && mixer_channels != 2))
+		return nullptr;
+	auto sample = std::make_unique<SampleBlock>(*this);
+	sample->set_loop(loop);
+	return sample;
+}
+
+
+/* ---------------------- SampleBlock ----------------------------- */
+
+SampleBlock::SampleBlock(const SourceBlock &s)
+: source {&s},
+  sample_step {static_cast<double>(s.sample_rate) / s.mixer_rate}
+{
+	for(auto &block : blocks)
+		block.frames.resize(static_cast<size_t>(s.block_frames) * s.channels);
+
+	/* read kernel */
+	if(s.mixer_channels == 1)
+	{
+		if(s.channels > 1)
+			read_fn = [this](int32_t *out, int32_t count, bool loop) { return read<true, false>(out, count, loop); };
+		else
+			read_fn = [this](int32_t *out, int32_t count, bool loop) { return read<false, false>(out, count, loop); };
+	}
+	else
+	{
+		if(s.channels > 1)
+			read_fn = [this](int32_t *out, int32_t count, bool loop) { return read<true, true>(out, count, loop); };
+		else
+			read_fn = [this](int32_t *out, int32_t count, bool loop) { return read<false, true>(out, count, loop); };
+	}
+}
+
+inline const int32_t *SampleBlock::frame(int32_t idx)
+{
+	const int32_t index = idx / source->block_frames;
+	const int32_t offset = (idx - index * source->block_frames) * source->channels;
+	if(blocks[last_block].index == index)
+		return blocks[last_block].frames.data() + offset;
+	last_block ^= 1;
+	Block &block = blocks[last_block];
+	if(block.index != index)
+	{
+		MAJIMIX_PROFILE_SCOPE(block_decode);
+		source->decode_block(index, block.frames.data(), state);
+		block.index = index;
+	}
+	return block.frames.data() + offset;
+}
+
+template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+inline int32_t *SampleBlock::interpolate(int32_t *out, const int32_t *a, const int32_t *b, double alpha) const
+{
+	// same arithmetic as SourcePCMF
+	if constexpr (STEREO_INPUT && STEREO_OUTPUT)
+	{
+		// stereo -> stereo (first two channels)
+		int32_t cl = a[0] + alpha * (b[0] - a[0]);
+		int32_t cr = a[1] + alpha * (b[1] - a[1]);
+		*out++ = cl;
+		*out++ = cr;
+	}
+	else if constexpr (STEREO_OUTPUT)
+	{
+		// mono -> stereo
+		int32_t v = a[0] + alpha * (b[0] - a[0]);
+		*out++ = v;
+		*out++ = v;
+	}
+	else if constexpr (STEREO_INPUT)
+	{
+		// stereo -> mono
+		int32_t v = (a[0] + a[1] + alpha * (b[0] - a[0] + b[1] - a[1])) * 0.5;
+		*out++ = v;
+	}
+	else
+	{
+		// mono -> mono
+		int32_t v = a[0] + alpha * (b[0] - a[0]);
+		*out++ = v;
+	}
+	return out;
+}
+
+template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+int32_t SampleBlock::read(int32_t *out_buffer, int32_t sample_count, bool loop)
+{
+	const SourceBlock &s = *source;
+	int32_t out_sample_count = 0;
+	if(sample_idx < s.size)
+	{
+		int32_t *out = out_buffer;
+
+		// looping : [0, end) then [start, end)
+		const int32_t end   = loop && s.loop_end ? s.loop_end : s.size;
+		const int32_t start = loop && s.loop_end ? s.loop_start : 0;
+
+		int32_t idx;
+		double idx_d;
+		double alpha;
+		// a is copied when b is in another block (the block of a can be replaced)
+		std::array<int32_t, 8> a;
+
+		while(out_sample_count < sample_count)
+		{
+			// frames interpolated with the next one in the data
+			int32_t max_sample_remaining = std::max(static_cast<int32_t>((end - sample_idx - 1) / sample_step), 0);
+			int32_t count = std::min(sample_count - out_sample_count, max_sample_remaining);
+
+			for(int sample_number = 0; sample_number < count; ++sample_number)
+			{
+				idx_d = sample_idx + sample_number * sample_step;
+				idx = static_cast<int32_t>(idx_d);
+				alpha = idx_d - idx;
+				const int32_t *pa = frame(idx);
+				if((idx + 1) % s.block_frames)
+					out = interpolate<STEREO_INPUT, STEREO_OUTPUT>(out, pa, pa + s.channels, alpha);
+				else
+				{
+					// block end
+					std::copy_n(pa, s.channels, a.data());
+					out = interpolate<STEREO_INPUT, STEREO_OUTPUT>(out, a.data(), frame(idx + 1), alpha);
+				}
+			}
+			out_sample_count += count;
+			sample_idx += count * sample_step;
+
+			if(!loop)
+				break;
+
+			// loop end : the last frames are interpolated with the loop start
+			while(out_sample_count < sample_count && sample_idx < end)
+			{
+				idx = static_cast<int32_t>(sample_idx);
+				alpha = sample_idx - idx;
+				std::copy_n(frame(idx), s.channels, a.data());
+				out = interpolate<STEREO_INPUT, STEREO_OUTPUT>(out, a.data(), frame(idx + 1 < end ? idx + 1 : start), alpha);
+				++out_sample_count;
+				sample_idx += sample_step;
+			}
+			while(sample_idx >= end)
+				sample_idx -= end - start;
+		}
+	}
+	return out_sample_count;
+}
+
+int32_t SampleBlock::read(int32_t *buffer, int32_t sample_count)
+{
+	MAJIMIX_PROFILE_SCOPE(block_resample);
+	int32_t r = read_fn(buffer, sample_count, looping.load(std::memory_order_relaxed));
+	if(r < sample_count)
+	{
+		// EOF - AUTOLOOP
+		sample_idx = 0;
+	}
+	return r;
+}
+
+void SampleBlock::seek(long pos)
+{
+	if(pos >= 0 && pos < source->size)
+		sample_idx = static_cast<double>(pos);
+}
+
+void SampleBlock::seek_time(double pos)
+{
+	if(pos >= 0)
+		seek(static_cast<long>(pos * source->sample_rate));
+}
+
+void SampleBlock::set_loop(bool loop)
+{
+	looping.store(loop, std::memory_order_relaxed);
+}
+
+}
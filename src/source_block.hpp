@@ -0,0 +1,146 @@
+/**
+ * @file source_block.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SOURCE_BLOCK_HPP_
+#define SOURCE_BLOCK_HPP_
+
+#include "interfaces.hpp"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace majimix 
+{
+
+/**
+ * @class SourceBlock
+ * @brief Source kept compressed in memory, made of blocks (ADPCM, QOA) : the samples decode
+ *        the block they play, seek and loop by decoding the block of the position.
+ */
+class SourceBlock : public Source
+{
+public:
+    /**
+     * Decoder state kept by a sample between two consecutive blocks, for the sources whose
+     * blocks depend on the previous ones (QOA : LMS predictors of the channels)
+     */
+    struct DecoderState {
+        /** the state is the one at the start of this block (-1 : none) */
+        int32_t next_block = -1;
+        std::array<int32_t, 64> values;
+    };
+
+protected:
+    int sample_rate = 0;
+    int channels = 0;
+    /** frames in a full block (all blocks are full but the last one) */
+    int block_frames = 0;
+    /** number of frames */
+    int32_t size = 0;
+    /** loop points (frames) : [loop_start, loop_end) - loop_end = 0 : no loop points */
+    int32_t loop_start = 0;
+    int32_t loop_end = 0;
+
+    /** mixer format */
+    int mixer_rate = 0;
+    int mixer_bits = 16;
+    int mixer_channels = 2;
+
+    friend class SampleBlock;
+
+public:
+    /** frames in a block (the last one can be shorter) */
+    int frames_in_block(int32_t block) const;
+    /**
+     * @brief Decode a block to the mixer format (int32, interleaved)
+     * @param out frames_in_block(block) x channels values
+     * @param state decoder state of the sample, updated for the next block
+     */
+    virtual void decode_block(int32_t block, int32_t *out, DecoderState &state) const = 0;
+
+    void set_output_format(int samples_per_sec, int channels = 2, int bits = 16) override;
+    bool get_loop_points(int64_t &start, int64_t &end) const override;
+    /* create a SampleBlock associated with this Source */
+    std::unique_ptr<Sample> create_sample(bool loop = false) override;
+};
+
+/**
+ * @class SampleBlock
+ * @brief Sample of a SourceBlock : same resampling as SamplePCMF, the frames are read from
+ *        the decoded blocks.
+ *
+ * Two decoded blocks are kept : the interpolated frames can be in two blocks (block end,
+ * loop end and loop start).
+ */
+class SampleBlock : public Sample
+{
+    const SourceBlock *source;
+
+    /** frame index */
+    double sample_idx = 0;
+    double sample_step;
+
+    /** played in a loop (mixer) */
+    std::atomic<bool> looping {false};
+
+    /** decoded blocks (mixer format) */
+    struct Block {
+        int32_t index = -1;
+        std::vector<int32_t> frames;
+    };
+    std::array<Block, 2> blocks;
+    /** block of the last frame */
+    int last_block = 0;
+    SourceBlock::DecoderState state;
+
+    /** Function pointer typedef for the read kernel */
+    using Reader = std::function<int32_t(int32_t *, int32_t, bool)>;
+    Reader read_fn;
+
+    /** frame idx (channels values) - the previous block stays decoded */
+    const int32_t *frame(int32_t idx);
+
+    template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+    int32_t *interpolate(int32_t *out, const int32_t *a, const int32_t *b, double alpha) const;
+
+    /** see SourcePCMF::read */
+    template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+    int32_t read(int32_t *out_buffer, int32_t sample_count, bool loop);
+
+public:
+    SampleBlock(const SourceBlock &s);
+    int32_t read(int32_t *buffer, int32_t sample_count) override;
+    void seek(long pos) override;
+    void seek_time(double pos) override;
+    void set_loop(bool loop) override;
+};
+
+}
+
+#endif
@@ -28,156 +28,325 @@
 #include "source_pcm.hpp"
 #include "wave.hpp"
 #include "converters.hpp"
+#include "profiler.hpp"
+#include "load_pool.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <thread>
 
 namespace majimix {
 
-void SourcePCM::set_output_format(int samples_per_sec, int channels, int bits)
+AuFormat wave_au_format(const wave::fmt_base &fmt)
 {
-	ready = false;
-	mixer_rate = samples_per_sec;
-	mixer_channels = channels;
-	mixer_bits = bits;
-	configure();
-}
-
-bool SourcePCM::load_wave(const std::string &filename)
-{
-	bool done = false;
-
-	/* reset previous format */
-	format = AuFormat::none;
-	ready = false;
-	pcm.clear();
-	data_size = 0;
-	decoder = nullptr;
-
-	wave::pcm_data pcm_data;
-
-	if(wave::load_wave(filename, pcm_data))
+	wave::WAVE_FORMAT wformat = wave::get_wave_format(fmt.wFormatTag);
+	uint16_t wFormatTag_ex = 0;
+	if(wformat == wave::WAVE_FORMAT::WAVE_FORMAT_EXTENSIBLE)
 	{
-		wave::fmt_base &fmt = pcm_data.fmt;
-
-		sample_rate         = fmt.nSamplesPerSec;
-		sample_size         = fmt.nBlockAlign;
-		channels            = fmt.nChannels;
-		channel_size        = fmt.nBlockAlign / fmt.nChannels;
-
-		data_size           = pcm_data.data.size();
-		size                = pcm_data.data.size() / fmt.nBlockAlign;
-		pcm                 = std::move(pcm_data.data);
-
-
-		wave::WAVE_FORMAT wformat = wave::get_wave_format(fmt.wFormatTag);
-		uint16_t wFormatTag_ex = 0;
-		if(wformat == wave::WAVE_FORMAT::WAVE_FORMAT_EXTENSIBLE)
+		// FORMAT EXTENSIBLE : search format in ex part
+		if(fmt.cbSize)
 		{
-			// FORMAT EXTENSIBLE : search format in ex part
-			if(fmt.cbSize)
-			{
-				wFormatTag_ex = reinterpret_cast<uint16_t&>(fmt.SubFormat);
-				wformat = wave::get_wave_format(wFormatTag_ex);
-			}
+			wFormatTag_ex = reinterpret_cast<const uint16_t&>(fmt.SubFormat);
+			wformat = wave::get_wave_format(wFormatTag_ex);
 		}
+	}
 #ifdef DEBUG
-		bool format_ex = fmt.cbSize && wformat == wave::WAVE_FORMAT::WAVE_FORMAT_EXTENSIBLE;
-		std::cout << "format          " << wformat << "\n";
-		std::cout << "channels        " << fmt.nChannels << "\n";
-		std::cout << "rate            " << fmt.nSamplesPerSec << "\n";
-		std::cout << "bits per sample (one channel) " << fmt.wBitsPerSample << "\n";
-		std::cout << "bytes for one sample and all channels " << fmt.nBlockAlign << "\n";
-
-		// review this check: case of 12bits which are aligned on 16bits (and treated as 16 bits)
-		std::cout << "format " << wformat << (format_ex ? " (EX)": "")<< " bps " << fmt.wBitsPerSample << " bits, " << fmt.nChannels << " channel(s) : nAvgBytesPerSec " << fmt.nAvgBytesPerSec<< " : nBlockAlign " << fmt.nBlockAlign << std::endl;
-		if(fmt.nAvgBytesPerSec != (fmt.nChannels * (fmt.wBitsPerSample>>3)) * fmt.nSamplesPerSec)
-		{
-			std::cerr << "format " << wformat << " bps " << fmt.wBitsPerSample << " bits, " << fmt.nChannels << " channel(s)" << " : nAvgBytesPerSec " << fmt.nAvgBytesPerSec << " mais il devrait être de " << ((fmt.nChannels * (fmt.wBitsPerSample>>3)) * fmt.nSamplesPerSec) << std::endl;
-		}
-		if(fmt.nBlockAlign * 8 != fmt.wBitsPerSample * fmt.nChannels)
-		{
-			std::cerr << "format " << wformat << " bps " << fmt.wBitsPerSample <<" bits, " << fmt.nChannels << " channel(s)" << " : nBlockAlign " << fmt.nBlockAlign << " => nBlockAlign * 8 ("<< (fmt.nBlockAlign * 8) <<")= wBitsPerSample * nChannels (" << (fmt.wBitsPerSample * fmt.nChannels) << ")"<< std::endl;
-		}
+	bool format_ex = fmt.cbSize && wformat == wave::WAVE_FORMAT::WAVE_FORMAT_EXTENSIBLE;
+	std::cout << "format          " << wformat << "\n";
+	std::cout << "channels        " << fmt.nChannels << "\n";
+	std::cout << "rate            " << fmt.nSamplesPerSec << "\n";
+	std::cout << "bits per sample (one channel) " << fmt.wBitsPerSample << "\n";
+	std::cout << "bytes for one sample and all channels " << fmt.nBlockAlign << "\n";
+
+	// review this check: case of 12bits which are aligned on 16bits (and treated as 16 bits)
+	std::cout << "format " << wformat << (format_ex ? " (EX)": "")<< " bps " << fmt.wBitsPerSample << " bits, " << fmt.nChannels << " channel(s) : nAvgBytesPerSec " << fmt.nAvgBytesPerSec<< " : nBlockAlign " << fmt.nBlockAlign << std::endl;
+	if(fmt.nAvgBytesPerSec != (fmt.nChannels * (fmt.wBitsPerSample>>3)) * fmt.nSamplesPerSec)
+	{
+		std::cerr << "format " << wformat << " bps " << fmt.wBitsPerSample << " bits, " << fmt.nChannels << " channel(s)" << " : nAvgBytesPerSec " << fmt.nAvgBytesPerSec << " mais il devrait être de " << ((fmt.nChannels * (fmt.wBitsPerSample>>3)) * fmt.nSamplesPerSec) << std::endl;
+	}
+	if(fmt.nBlockAlign * 8 != fmt.wBitsPerSample * fmt.nChannels)
+	{
+		std::cerr << "format " << wformat << " bps " << fmt.wBitsPerSample <<" bits, " << fmt.nChannels << " channel(s)" << " : nBlockAlign " << fmt.nBlockAlign << " => nBlockAlign * 8 ("<< (fmt.nBlockAlign * 8) <<")= wBitsPerSample * nChannels (" << (fmt.wBitsPerSample * fmt.nChannels) << ")"<< std::endl;
+	}
 #endif
 
-		switch(wformat)
-		{
-		case wave::WAVE_FORMAT::WAVE_FORMAT_ALAW:
-			format = AuFormat::alaw;
-			break;
-		case wave::WAVE_FORMAT::WAVE_FORMAT_MULAW:
-			format = AuFormat::ulaw;
-			break;
-		case wave::WAVE_FORMAT::WAVE_FORMAT_PCM :
+	switch(wformat)
+	{
+	case wave::WAVE_FORMAT::WAVE_FORMAT_ALAW:
+		return AuFormat::alaw;
+	case wave::WAVE_FORMAT::WAVE_FORMAT_MULAW:
+		return AuFormat::ulaw;
+	case wave::WAVE_FORMAT::WAVE_FORMAT_PCM :
+	{
+		switch(fmt.wBitsPerSample)
 		{
-			switch(fmt.wBitsPerSample)
-			{
-			case 8 :
-				format = AuFormat::uint_8bits;
-				break;
-			case 12 : // ??? : 12 bits - first byte (less significant) the first 4 bits are 0 => we have to load int16 then (>>4)
-			case 16 :
-				format = AuFormat::int_16bits;
-				break;
-			case 24 :
-				format = AuFormat::int_24bits;
-				break;
-			case 32 :
-				format = AuFormat::int_32bits;
-				break;
-			default:
+		case 8 :
+			return AuFormat::uint_8bits;
+		case 12 : // ??? : 12 bits - first byte (less significant) the first 4 bits are 0 => we have to load int16 then (>>4)
+		case 16 :
+			return AuFormat::int_16bits;
+		case 24 :
+			return AuFormat::int_24bits;
+		case 32 :
+			return AuFormat::int_32bits;
+		default:
 #ifdef DEBUG
-				std::cerr << "format WAVE_FORMAT_PCM avec wBitsPerSample = " << fmt.wBitsPerSample << " not implemented" << std::endl;
+			std::cerr << "format WAVE_FORMAT_PCM avec wBitsPerSample = " << fmt.wBitsPerSample << " not implemented" << std::endl;
 #endif
-				break;
-			}
 			break;
 		}
-		case wave::WAVE_FORMAT::WAVE_FORMAT_IEEE_FLOAT : {
-			switch(fmt.wBitsPerSample)
-			{
-			case 32 :
-				format = AuFormat::float_32bits;
-				break;
-			case 64 :
-				format = AuFormat::float_64bits;
-				break;
-			default:
+		break;
+	}
+	case wave::WAVE_FORMAT::WAVE_FORMAT_IEEE_FLOAT : {
+		switch(fmt.wBitsPerSample)
+		{
+		case 32 :
+			return AuFormat::float_32bits;
+		case 64 :
+			return AuFormat::float_64bits;
+		default:
 #ifdef DEBUG
-				std::cerr << "Format WAVE_FORMAT_IEEE_FLOAT "<< fmt.wBitsPerSample << " bits not supported" << std::endl;
+			std::cerr << "Format WAVE_FORMAT_IEEE_FLOAT "<< fmt.wBitsPerSample << " bits not supported" << std::endl;
 #endif
-				break;
-			}
 			break;
 		}
+		break;
+	}
 
-		//  WAVE_FORMAT_EXTENSIBLE format should be used whenever:
-		//
-		//  PCM data has more than 16 bits/sample.
-		//  The number of channels is more than 2.
-		//  The actual number of bits/sample is not equal to the container size.
-		//  The mapping from channels to speakers needs to be specified.
+	//  WAVE_FORMAT_EXTENSIBLE format should be used whenever:
+	//
+	//  PCM data has more than 16 bits/sample.
+	//  The number of channels is more than 2.
+	//  The actual number of bits/sample is not equal to the container size.
+	//  The mapping from channels to speakers needs to be specified.
 
-		default:
+	default:
 #ifdef DEBUG
-			std::cerr << "unsupported format WAVE_FORMAT_EXTENSIBLE" << std::endl;
+		std::cerr << "unsupported format WAVE_FORMAT_EXTENSIBLE" << std::endl;
 #endif
-			break;
+		break;
+	}
+	return AuFormat::none;
+}
+
+std::function<int32_t(const char *)> pcm_decoder(AuFormat format, int mixer_bits)
+{
+	switch(format)
+	{
+	case AuFormat::alaw:
+		return mixer_bits == 16 ? converters::alaw : converters::alaw_i24;
+	case AuFormat::ulaw:
+		return mixer_bits == 16 ? converters::ulaw : converters::ulaw_i24;
+	case AuFormat::uint_8bits:
+		return mixer_bits == 16 ? converters::ui8_to_i16 : converters::ui8_to_i24;
+	case AuFormat::int_16bits:
+		return mixer_bits == 16 ? converters::in_to_i16_le<2> : converters::in_to_i24_le<2>;
+	case AuFormat::int_24bits:
+		return mixer_bits == 16 ? converters::in_to_i16_le<3> : converters::in_to_i24_le<3>;
+	case AuFormat::int_32bits:
+		return mixer_bits == 16 ? converters::in_to_i16_le<4> : converters::in_to_i24_le<4>;
+	case AuFormat::float_32bits:
+		return mixer_bits == 16 ? converters::float_to_i16<float> : converters::float_to_i24<float>;
+	case AuFormat::float_64bits:
+		return mixer_bits == 16 ? converters::float_to_i16<double> : converters::float_to_i24<double>;
+	default:
+		return nullptr;
+	}
+}
+
+bool pcm_native_converted(AuFormat format, int mixer_bits)
+{
+	return format == AuFormat::float_64bits || format == AuFormat::float_32bits
+	    || (mixer_bits == 16 && (format == AuFormat::int_24bits || format == AuFormat::int_32bits));
+}
+
+void pcm_to_native(const char *in, AuFormat format, int channel_size, int mixer_bits, size_t count, char *out)
+{
+	auto decoder = pcm_decoder(format, mixer_bits);
+	auto *o = reinterpret_cast<unsigned char *>(out);
+	for(size_t i = 0; i < count; ++i, in += channel_size)
+	{
+		int32_t v = decoder(in);
+		if(mixer_bits == 16)
+		{
+			v = std::clamp(v, -32768, 32767);
+			*o++ = static_cast<unsigned char>(v);
+			*o++ = static_cast<unsigned char>(v >> 8);
+		}
+		else
+		{
+			uint32_t u = static_cast<uint32_t>(std::clamp(v, -8388608, 8388607)) << 8;
+			*o++ = static_cast<unsigned char>(u);
+			*o++ = static_cast<unsigned char>(u >> 8);
+			*o++ = static_cast<unsigned char>(u >> 16);
+			*o++ = static_cast<unsigned char>(u >> 24);
 		}
-		done = format != AuFormat::none;
-		if(done)
-			configure();
 	}
+}
+
+void SourcePCM::set_output_format(int samples_per_sec, int channels, int bits)
+{
+	ready = false;
+	mixer_rate = samples_per_sec;
+	mixer_channels = channels;
+	mixer_bits = bits;
+	configure();
+}
+
+bool SourcePCM::load_wave(const std::string &filename, bool mapped)
+{
+	// shared data : the data chunk is read by the cache (if it is not already loaded)
+	wave::pcm_data pcm_data;
+	if(!wave::load_wave(filename, pcm_data, !mapped && !shared))
+	{
 #ifdef DEBUG
+		std::cerr << "No file found\n";
+#endif
+		return false;
+	}
+	return load_wave(filename, pcm_data, mapped);
+}
+
+bool SourcePCM::load_wave(const std::string &filename, wave::pcm_data &pcm_data, bool mapped)
+{
+	/* reset previous format */
+	format = AuFormat::none;
+	ready = false;
+	pcm.reset();
+	loaded.reset();
+	shared_file.clear();
+	mapping.reset();
+	samples = nullptr;
+	data_size = 0;
+	decoder = nullptr;
+
+	wave::fmt_base &fmt = pcm_data.fmt;
+
+	// larger files (RF64, Wave64) can only be streamed
+	if(pcm_data.data_size > static_cast<uint64_t>(INT32_MAX) || !fmt.nChannels || !fmt.nBlockAlign)
+		return false;
+	// the format is checked before the data is loaded
+	const AuFormat file_format = wave_au_format(fmt);
+	if(file_format == AuFormat::none)
+		return false;
+
+	if(mapped)
+	{
+		// the data chunk must be in the file (truncated file : the access would fault)
+		auto file = std::make_unique<MappedFile>();
+		if(!file->open(filename) || pcm_data.data_offset + pcm_data.data_size > file->size())
+			return false;
+		samples = file->data() + pcm_data.data_offset;
+		mapping = std::move(file);
+	}
+	else if(!shared && pcm_data.data.size() == pcm_data.data_size)
+		pcm = std::make_shared<const Blob>(std::move(pcm_data.data));
 	else
 	{
-		std::cerr << "No file found\n";
+		// data chunk not read with the headers
+		const uint64_t offset = pcm_data.data_offset;
+		const size_t length = static_cast<size_t>(pcm_data.data_size);
+		auto load = [&](std::vector<char> &data) {
+			std::ifstream stream(filename, std::ios::binary);
+			data.resize(length);
+			stream.seekg(offset);
+			stream.read(data.data(), length);
+			return static_cast<bool>(stream);
+		};
+		pcm = shared ? AssetCache::instance().get(filename, AssetCache::Content::wave_data, load) : AssetCache::load(load);
+		if(!pcm)
+			return false;
+		if(shared)
+			shared_file = filename;
 	}
-#endif
+
+	sample_rate         = fmt.nSamplesPerSec;
+	sample_size         = fmt.nBlockAlign;
+	channels            = fmt.nChannels;
+	channel_size        = fmt.nBlockAlign / fmt.nChannels;
+
+	data_size           = pcm_data.data_size;
+	size                = pcm_data.data_size / fmt.nBlockAlign;
+	if(!mapped)
+		samples         = pcm->data();
+	loop_start          = 0;
+	loop_end            = 0;
+	if(pcm_data.loop_end)
+		set_loop_points(pcm_data.loop_start, pcm_data.loop_end);
+
+
+	format = file_format;
+	configure();
+	return true;
+}
+
+bool SourcePCM::set_pcm(AssetCache::Data data, AuFormat format, int rate, int channels, int channel_size)
+{
+	this->format       = format;
+	this->sample_rate  = rate;
+	this->channels     = channels;
+	this->channel_size = channel_size;
+	sample_size        = channel_size * channels;
+	data_size          = data ? static_cast<int32_t>(data->size()) : 0;
+	size               = sample_size ? data_size / sample_size : 0;
+	pcm                = std::move(data);
+	loaded.reset();
+	shared_file.clear();
+	mapping.reset();
+	samples            = pcm ? pcm->data() : nullptr;
+	loop_start         = 0;
+	loop_end           = 0;
+	decoder            = nullptr;
+	ready              = false;
+
+	bool done = format != AuFormat::none && size > 0;
+	if(done)
+		configure();
+	return done;
+}
+
+bool SourcePCM::set_mapped(std::shared_ptr<const MappedFile> file, uint64_t offset, uint64_t size,
+                           AuFormat format, int rate, int channels, int channel_size)
+{
+	if(!file || offset + size > file->size() || size > static_cast<uint64_t>(INT32_MAX))
+		return false;
+	this->format       = format;
+	this->sample_rate  = rate;
+	this->channels     = channels;
+	this->channel_size = channel_size;
+	sample_size        = channel_size * channels;
+	data_size          = static_cast<int32_t>(size);
+	this->size         = sample_size ? data_size / sample_size : 0;
+	pcm.reset();
+	loaded.reset();
+	shared_file.clear();
+	samples            = file->data() + offset;
+	mapping            = std::move(file);
+	loop_start         = 0;
+	loop_end           = 0;
+	decoder            = nullptr;
+	ready              = false;
+
+	bool done = format != AuFormat::none && this->size > 0;
+	if(done)
+		configure();
 	return done;
 }
 
 void SourcePCM::configure()
 {
 	ready = false;
+	// converted data : the conversion is done again from the loaded data (int16 can not be played at 24 bits)
+	if(loaded)
+	{
+		pcm          = loaded;
+		samples      = pcm->data();
+		format       = loaded_format;
+		channel_size = loaded_channel_size;
+		sample_size  = channel_size * channels;
+		data_size    = static_cast<int32_t>(pcm->size());
+	}
 	/* source format & data */
 	if(sample_rate   > 0 &&
 	   sample_size     > 0 &&
@@ -185,7 +354,7 @@ void SourcePCM::configure()
 	   channel_size    > 0 &&
 	   data_size       > 0 &&
 	   size            > 0 &&
-	   pcm.size()     == static_cast<size_t>(data_size)&&
+	   samples         != nullptr &&
 	   mixer_rate      > 0 &&
 	   ((mixer_bits == 16) | (mixer_bits == 24)) &&
 	   mixer_channels  > 0)
@@ -204,39 +373,97 @@ void SourcePCM::configure()
 #endif
 
 		/* decoder */
-		switch(format)
-		{
-		case AuFormat::alaw:
-			decoder = mixer_bits == 16 ? converters::alaw : converters::alaw_i24;
-		break;
-		case AuFormat::ulaw:
-			decoder = mixer_bits == 16 ? converters::ulaw : converters::ulaw_i24;
-		break;
-		case AuFormat::uint_8bits:
-			decoder = mixer_bits == 16 ? converters::ui8_to_i16 : converters::ui8_to_i24;
-		break;
-		case AuFormat::int_16bits:
-			decoder = mixer_bits == 16 ? converters::in_to_i16_le<2> : converters::in_to_i24_le<2>;
-		break;
-		case AuFormat::int_24bits:
-			decoder = mixer_bits == 16 ? converters::in_to_i16_le<3> : converters::in_to_i24_le<3>;
-		break;
-		case AuFormat::int_32bits:
-			decoder = mixer_bits == 16 ? converters::in_to_i16_le<4> : converters::in_to_i24_le<4>;
-		break;
-		case AuFormat::float_32bits:
-			decoder = mixer_bits == 16 ? converters::float_to_i16<float> : converters::float_to_i24<float>;
-		break;
-		case AuFormat::float_64bits:
-			decoder = mixer_bits == 16 ? converters::float_to_i16<double> : converters::float_to_i24<double>;
-		break;
-		default:
+		decoder = pcm_decoder(format, mixer_bits);
+		if(!decoder)
 			return;
+
+		// once : the data becomes int16 / int32
+		if(native && convert_to_native())
+			decoder = pcm_decoder(format, mixer_bits);
+
+		/* access of the read kernels */
+		storage = Storage::encoded;
+		if(format == AuFormat::uint_8bits || format == AuFormat::alaw || format == AuFormat::ulaw)
+		{
+			for(int i = 0; i < 256; ++i)
+			{
+				char value = static_cast<char>(i);
+				table[i] = decoder(&value);
+			}
+			storage = Storage::table;
 		}
+		else if(wave::little_endian && format == AuFormat::int_16bits && mixer_bits == 16)
+			storage = Storage::i16;
+		else if(wave::little_endian && format == AuFormat::int_32bits && mixer_bits == 24)
+			storage = Storage::i32;
 		ready = true;
 	}
 }
 
+bool SourcePCM::convert_to_native()
+{
+	// 16 bits mixer : int16 (2 bytes) - 24 bits mixer : int32 (4 bytes, the 24 bits value << 8)
+	const bool mixer_16 = mixer_bits == 16;
+	if(!pcm_native_converted(format, mixer_bits) || mapping || !pcm || samples != pcm->data())
+		return false;
+
+	const int native_size = mixer_16 ? 2 : 4;
+	const size_t values = static_cast<size_t>(size) * channels;
+
+	auto convert_range = [&](std::vector<char> &converted, size_t first, size_t last) {
+		pcm_to_native(samples + first * channel_size, format, channel_size, mixer_bits, last - first,
+		              converted.data() + first * native_size);
+	};
+
+	// long data : segments converted concurrently
+	auto convert_all = [&](std::vector<char> &converted) {
+		converted.resize(values * native_size);
+		constexpr size_t min_segment_values = 1 << 20;
+		// a single thread on a LoadPool worker : the loads are already run in parallel
+		const size_t threads = LoadPool::is_worker() ? 1 : std::max(1u, std::thread::hardware_concurrency());
+		const size_t segments = std::clamp<size_t>(values / min_segment_values, 1, threads);
+		std::vector<std::thread> workers;
+		for(size_t i = 1; i < segments; ++i)
+			workers.emplace_back(convert_range, std::ref(converted), values * i / segments, values * (i + 1) / segments);
+		convert_range(converted, 0, values / segments);
+		for(auto &w : workers)
+			w.join();
+		return true;
+	};
+
+	AssetCache::Data converted;
+	if(!shared_file.empty())
+		converted = AssetCache::instance().get(shared_file, mixer_16 ? AssetCache::Content::native_16 : AssetCache::Content::native_24, convert_all);
+	else
+		converted = AssetCache::load(convert_all);
+	if(!converted)
+		return false;
+
+#ifdef DEBUG
+	std::cout << "converted to int" << (native_size * 8) << " : " << data_size << " => " << converted->size() << " bytes\n";
+#endif
+	loaded              = std::move(pcm);
+	loaded_format       = format;
+	loaded_channel_size = channel_size;
+	pcm          = std::move(converted);
+	samples      = pcm->data();
+	format       = mixer_16 ? AuFormat::int_16bits : AuFormat::int_32bits;
+	channel_size = native_size;
+	sample_size  = native_size * channels;
+	data_size    = static_cast<int32_t>(pcm->size());
+	return true;
+}
+
+void SourcePCM::set_native(bool enable)
+{
+	native = enable;
+}
+
+void SourcePCM::set_shared(bool enable)
+{
+	shared = enable;
+}
+
 
 // /*
 //  * For fixed-point calculation
@@ -453,164 +680,209 @@ void SourcePCMF::configure()
 		sample_step = static_cast<double>(sample_rate) / mixer_rate;
 
 		/* read function */
-		if(mixer_channels == 1)
-		{
-			if(channels > 1)
-				read_fn = std::bind(&SourcePCMF::read<true, false>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-			else
-				read_fn = std::bind(&SourcePCMF::read<false, false>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-		}
-		else if(mixer_channels == 2)
+		switch(storage)
 		{
-			if(channels > 1)
-				read_fn = std::bind(&SourcePCMF::read<true, true>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
-			else
-				read_fn = std::bind(&SourcePCMF::read<false, true>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3);
+		case Storage::table:
+			bind_read<Storage::table>();
+			break;
+		case Storage::i16:
+			bind_read<Storage::i16>();
+			break;
+		case Storage::i32:
+			bind_read<Storage::i32>();
+			break;
+		default:
+			bind_read<Storage::encoded>();
+			break;
 		}
 	}
 }
 
-std::unique_ptr<Sample> SourcePCMF::create_sample()
+template<SourcePCM::Storage STORAGE>
+void SourcePCMF::bind_read()
 {
-	if(ready)
-		return std::make_unique<SamplePCMF>(*this);
-	return nullptr;
+	if(mixer_channels == 1)
+	{
+		if(channels > 1)
+			read_fn = std::bind(&SourcePCMF::read<STORAGE, true, false>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+		else
+			read_fn = std::bind(&SourcePCMF::read<STORAGE, false, false>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+	}
+	else if(mixer_channels == 2)
+	{
+		if(channels > 1)
+			read_fn = std::bind(&SourcePCMF::read<STORAGE, true, true>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+		else
+			read_fn = std::bind(&SourcePCMF::read<STORAGE, false, true>, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::placeholders::_4);
+	}
+}
+
+std::unique_ptr<Sample> SourcePCMF::create_sample(bool loop)
+{
+	if(!ready)
+		return nullptr;
+	auto sample = std::make_unique<SamplePCMF>(*this);
+	sample->set_loop(loop);
+	return sample;
 }
 
 
-template<bool STEREO_INPUT, bool STEREO_OUTPUT>
-int32_t SourcePCMF::read(int32_t* out_buffer, int32_t sample_count, double &sample_idx) const
+template<SourcePCM::Storage STORAGE>
+inline int32_t SourcePCMF::fetch(const char *data) const
+{
+	if constexpr (STORAGE == Storage::table)
+		return table[static_cast<unsigned char>(*data)];
+	else if constexpr (STORAGE == Storage::i16)
+	{
+		int16_t v;
+		std::memcpy(&v, data, sizeof v);
+		return v;
+	}
+	else if constexpr (STORAGE == Storage::i32)
+	{
+		// 24 bits
+		int32_t v;
+		std::memcpy(&v, data, sizeof v);
+		return v >> 8;
+	}
+	else
+		return decoder(data);
+}
+
+template<SourcePCM::Storage STORAGE, bool STEREO_INPUT, bool STEREO_OUTPUT>
+inline int32_t *SourcePCMF::interpolate(int32_t *out, const char *a, const char *b, double alpha) const
+{
+	if constexpr (STEREO_INPUT && STEREO_OUTPUT)
+	{
+		// stereo -> stereo
+		int32_t cl1 = fetch<STORAGE>(a);
+		int32_t cr1 = fetch<STORAGE>(a + channel_size);
+		int32_t cl2 = fetch<STORAGE>(b);
+		int32_t cr2 = fetch<STORAGE>(b + channel_size);
+
+		// imprecise
+		int32_t cl = cl1 + alpha * (cl2 - cl1);
+		int32_t cr = cr1 + alpha * (cr2 - cr1);
+
+		// precise
+		// cl = (1. - alpha) * cl1 + alpha * cl2;
+		// cr = (1. - alpha) * cr1 + alpha * cr2;
+
+		*out++ = cl;
+		*out++ = cr;
+	}
+	else if constexpr (STEREO_OUTPUT)
+	{
+		// mono -> stereo
+		int32_t input_val1 = fetch<STORAGE>(a);
+		int32_t input_val2 = fetch<STORAGE>(b);
+		int32_t output_val = input_val1 + alpha * (input_val2 - input_val1);
+		*out++ = output_val;
+		*out++ = output_val;
+	}
+	else if constexpr (STEREO_INPUT)
+	{
+		// stereo -> mono
+		int32_t input_l1 = fetch<STORAGE>(a);
+		int32_t input_r1 = fetch<STORAGE>(a + channel_size);
+		int32_t input_l2 = fetch<STORAGE>(b);
+		int32_t input_r2 = fetch<STORAGE>(b + channel_size);
+		int32_t output_val = (input_l1 + input_r1 + alpha * (input_l2 - input_l1 + input_r2 - input_r1)) * 0.5;
+		*out++ = output_val;
+	}
+	else
+	{
+		// mono -> mono
+		int32_t input_v1 = fetch<STORAGE>(a);
+		int32_t input_v2 = fetch<STORAGE>(b);
+		int32_t output_val = input_v1 + alpha * (input_v2 - input_v1);
+		*out++ = output_val;
+	}
+	return out;
+}
+
+template<SourcePCM::Storage STORAGE, bool STEREO_INPUT, bool STEREO_OUTPUT>
+int32_t SourcePCMF::read(int32_t* out_buffer, int32_t sample_count, double &sample_idx, bool loop) const
 {
 	int32_t out_sample_count = 0;
 	if (sample_idx < size)
 	{
-		
-		const char *data = pcm.data();
+		const char *data = samples;
 		int32_t *out = out_buffer;
 
-		// auto idx_start = sample_idx * sample_size;
-		// !!! il faut raisonner en sample auto step = sample_step_d * sample_size;
+		// looping : [0, end) then [start, end)
+		const int32_t end   = loop && loop_end ? loop_end : size;
+		const int32_t start = loop && loop_end ? loop_start : 0;
 
-		int32_t max_sample_remaining = static_cast<int32_t>((size - sample_idx - 1) / sample_step);
-		sample_count = std::min(sample_count, max_sample_remaining);
 		int32_t idx;
 		double idx_d;
 		double alpha;
 
-		if constexpr (STEREO_INPUT && STEREO_OUTPUT)
+		while(out_sample_count < sample_count)
 		{
-			// stereo -> stereo
-			int32_t cl1, cr1, cl2, cr2, cl, cr;
-
-			for(int sample_number = 0; sample_number < sample_count; ++sample_number)
-			{
-				idx_d = sample_idx + sample_number * sample_step;
-				idx = static_cast<int32_t>(idx_d);
-				alpha = idx_d - idx;
-
-				idx *= sample_size; 
+			// frames interpolated with the next one in the data
+			int32_t max_sample_remaining = std::max(static_cast<int32_t>((end - sample_idx - 1) / sample_step), 0);
+			int32_t count = std::min(sample_count - out_sample_count, max_sample_remaining);
 
-				cl1 = decoder(data + idx);
-				cr1 = decoder(data + idx + channel_size);
-
-				// max_remaining : idx = (idx + sample_size) % data_size;
-				idx += sample_size;
-
-				cl2 = decoder(data + idx);
-				cr2 = decoder(data + idx + channel_size);
-
-				// imprecise
-				cl = cl1 + alpha * (cl2 - cl1);
-				cr = cr1 + alpha * (cr2 - cr1);
-
-				// precise
-				// cl = (1. - alpha) * cl1 + alpha * cl2;
-				// cr = (1. - alpha) * cr1 + alpha * cr2;
-
-				*out++ = cl;
-				*out++ = cr;
-				// ++out_sample_count;
-			}
-			out_sample_count = sample_count;
-			sample_idx +=  sample_count * sample_step;
-		}
-		else if constexpr (STEREO_OUTPUT)
-		{
-			// mono -> stereo
-			int32_t input_val1, input_val2, output_val;
-			for(int sample_number = 0; sample_number < sample_count; ++sample_number)
+			for(int sample_number = 0; sample_number < count; ++sample_number)
 			{
 				idx_d = sample_idx + sample_number * sample_step;
 				idx = static_cast<int32_t>(idx_d);
 				alpha = idx_d - idx;
 
-				idx *= sample_size; 
-
-				input_val1 = decoder(data + idx);
-				idx += sample_size;
-				input_val2 = decoder(data + idx);
-
-				output_val = input_val1 + alpha * (input_val2 - input_val1);
-				*out++ = output_val;
-				*out++ = output_val;
+				idx *= sample_size;
+				out = interpolate<STORAGE, STEREO_INPUT, STEREO_OUTPUT>(out, data + idx, data + idx + sample_size, alpha);
 			}
-			out_sample_count = sample_count;
-			sample_idx +=  sample_count * sample_step;
+			out_sample_count += count;
+			sample_idx +=  count * sample_step;
 
-		}
-		else if constexpr (STEREO_INPUT)
-		{
-			// stereo -> mono
-			int32_t input_l1, input_l2, input_r1, input_r2, output_val;
-			for(int sample_number = 0; sample_number < sample_count; ++sample_number)
-			{
-				idx_d = sample_idx + sample_number * sample_step;
-				idx = static_cast<int32_t>(idx_d);
-				alpha = idx_d - idx;
-
-				idx *= sample_size; 
-
-				input_l1 = decoder(data + idx);
-				input_r1 = decoder(data + idx + channel_size);
-
-				idx += sample_size;
-
-				input_l2 = decoder(data + idx);
-				input_r2 = decoder(data + idx + channel_size);
+			if(!loop)
+				break;
 
-				output_val = (input_l1 + input_r1 + alpha * (input_l2 - input_l1 + input_r2 - input_r1)) * 0.5;
-				*out++ = output_val;
-			}
-			out_sample_count = sample_count;
-			sample_idx +=  sample_count * sample_step;
-		}
-		else
-		{
-			// mono -> mono
-			int32_t input_v1, input_v2, output_val;
-			for(int sample_number = 0; sample_number < sample_count; ++sample_number)
+			// loop end : the last frames are interpolated with the loop start
+			while(out_sample_count < sample_count && sample_idx < end)
 			{
-				idx_d = sample_idx + sample_number * sample_step;
-				idx = static_cast<int32_t>(idx_d);
-				alpha = idx_d - idx;
-
-				idx *= sample_size; 
-
-				input_v1 = decoder(data + idx);
-				idx += sample_size;
-				input_v2 = decoder(data + idx);
-
-				output_val = input_v1 + alpha * (input_v2 - input_v1);
-				*out++ = output_val;
+				idx = static_cast<int32_t>(sample_idx);
+				alpha = sample_idx - idx;
+				const char *a = data + idx * sample_size;
+				const char *b = idx + 1 < end ? a + sample_size : data + start * sample_size;
+				out = interpolate<STORAGE, STEREO_INPUT, STEREO_OUTPUT>(out, a, b, alpha);
+				++out_sample_count;
+				sample_idx += sample_step;
 			}
-			out_sample_count = sample_count;
-			sample_idx +=  sample_count * sample_step;
+			while(sample_idx >= end)
+				sample_idx -= end - start;
 		}
+	}
+	return out_sample_count;
+}
 
+bool SourcePCM::set_loop_points(int64_t start, int64_t end)
+{
+	if(start < 0 || start >= end || end > size)
+		return false;
+	loop_start = static_cast<int32_t>(start);
+	loop_end = static_cast<int32_t>(end);
+	return true;
+}
 
+bool SourcePCM::get_loop_points(int64_t &start, int64_t &end) const
+{
+	if(!loop_end)
+		return false;
+	start = loop_start;
+	end = loop_end;
+	return true;
+}
 
-	}
-	return out_sample_count;
+size_t SourcePCM::memory_size() const
+{
+	// the mapped data is in the page cache
+	// mapped from the disk cache : in the page cache
+	size_t total = pcm && !pcm->mapped() ? pcm->size() : 0;
+	if(loaded && loaded != pcm && !loaded->mapped())
+		total += loaded->size();
+	return total;
 }
 
 SamplePCMF::SamplePCMF(const SourcePCMF &s) : source {&s}
@@ -619,7 +891,8 @@ SamplePCMF::SamplePCMF(const SourcePCMF &s) : source {&s}
 
 int32_t SamplePCMF::read(int32_t* buffer, int32_t sample_count)
 {
-	int32_t r = source->read_fn(buffer, sample_count, sample_idx);
+	MAJIMIX_PROFILE_SCOPE(pcm_resample);
+	int32_t r = source->read_fn(buffer, sample_count, sample_idx, looping.load(std::memory_order_relaxed));
 	if(r < sample_count)
 	{
 		// EOF - AUTOLOOP
@@ -628,6 +901,11 @@ int32_t SamplePCMF::read(int32_t* buffer, int32_t sample_count)
 	return r;
 }
 
+void SamplePCMF::set_loop(bool loop)
+{
+	looping.store(loop, std::memory_order_relaxed);
+}
+
 void SamplePCMF::seek(long pos)
 {
 	if(source && pos < source->size && pos >= 0)
@@ -29,11 +29,34 @@
 #define SOURCES_PCM_HPP_
 
 #include "interfaces.hpp"
+#include "mapped_file.hpp"
+#include "asset_cache.hpp"
+#include <array>
+#include <atomic>
 #include <functional>
+#include <memory>
 
 namespace majimix 
 {
 
+namespace wave { struct fmt_base; struct pcm_data; }
+
+/** sample format of a WAVE file - AuFormat::none : not supported */
+AuFormat wave_au_format(const wave::fmt_base &fmt);
+
+/** decoder of one channel of a sample to the mixer format (16 or 24 bits) - nullptr : not supported */
+std::function<int32_t(const char *)> pcm_decoder(AuFormat format, int mixer_bits);
+
+/** the formats converted to the mixer format by SourceOptions::pcm_native : float, and 24 / 32 bits for a 16 bits mixer */
+bool pcm_native_converted(AuFormat format, int mixer_bits);
+
+/**
+ * convert count channel values to the mixer format, little-endian (as the WAVE data) :
+ * int16 for a 16 bits mixer, int32 (the 24 bits value << 8) for a 24 bits mixer
+ * out : count x 2 or 4 bytes
+ */
+void pcm_to_native(const char *in, AuFormat format, int channel_size, int mixer_bits, size_t count, char *out);
+
 /**
  * @brief Base classe for PCM sources
  * 
@@ -41,6 +64,15 @@ namespace majimix
 class SourcePCM : public Source 
 {
 protected:
+    /** how the read kernels get a channel value */
+    enum class Storage
+    {
+        encoded, /**< decoder call */
+        table,   /**< 8 bits formats (u8, a-law, u-law) : lookup table */
+        i16,     /**< 16 bits, 16 bits mixer : plain load */
+        i32      /**< 32 bits, 24 bits mixer : plain load and shift */
+    };
+
     bool ready = false;
 
     /** sample format */
@@ -57,11 +89,31 @@ protected:
     int32_t data_size;
     /** number of sample */
     int32_t size;
-    /** pcm data */
-    std::vector<char> pcm;
+    /** pcm data (heap storage) - immutable, shared with the other sources of the same file */
+    AssetCache::Data pcm;
+    /** mapped file (mapped storage) - shared with the other sources of a sound bank */
+    std::shared_ptr<const MappedFile> mapping;
+    /** first byte of the pcm data : pcm or the data chunk in the mapped file */
+    const char *samples = nullptr;
+    /** loop points (samples) : [loop_start, loop_end) - loop_end = 0 : no loop points */
+    int32_t loop_start = 0;
+    int32_t loop_end = 0;
 
     /** sample decoder */
     std::function<int32_t(const char *)> decoder;
+    Storage storage = Storage::encoded;
+    /** decoded values of the 8 bits formats */
+    std::array<int32_t, 256> table;
+    /** convert the data to the mixer format when it is configured (heap storage) */
+    bool native = false;
+    /** data as loaded, before the native conversion : converted again when the mixer format changes */
+    AssetCache::Data loaded;
+    AuFormat loaded_format = AuFormat::none;
+    int loaded_channel_size = 0;
+    /** the data is loaded through the AssetCache */
+    bool shared = false;
+    /** WAVE file of the shared data (cache key of the converted data) - empty : not shared */
+    std::string shared_file;
 
     /** mixer format : rate */
     int mixer_rate;
@@ -71,14 +123,68 @@ protected:
     int mixer_channels;
 
     virtual void configure();
+    /**
+     * @brief Convert the data to int16 (16 bits mixer) or int32 (24 bits mixer) if it is smaller
+     *        or as large and slower to decode - long data is converted by several threads.
+     *        The loaded data is kept : the conversion is always done from it.
+     * @return true if the data was converted
+     */
+    bool convert_to_native();
 
 public:
     virtual ~SourcePCM() = default;
     void set_output_format(int samples_per_sec, int channels = 2, int bits = 16) override;
-    bool load_wave(const std::string &filename);
+    /**
+     * @brief Load a WAVE file
+     * @param mapped the file is mapped in memory and the data chunk played from the mapping :
+     *               only the headers are read, the pages are loaded (and shared with the page cache)
+     *               when they are played
+     */
+    bool load_wave(const std::string &filename, bool mapped = false);
+    /**
+     * @brief Load a WAVE file whose headers are already read
+     * @param pcm_data headers (wave::load_wave) - the data chunk is read if it was not loaded with them
+     */
+    bool load_wave(const std::string &filename, wave::pcm_data &pcm_data, bool mapped = false);
+    /**
+     * @brief The data is converted once to the mixer sample type (int16 or int32) when the format
+     *        is set : the read kernels no longer decode it. The 8 bits formats are not converted
+     *        (lookup table) nor is the mapped data. Call before loading the data.
+     */
+    void set_native(bool enable);
+    /**
+     * @brief The data is shared (AssetCache) with all the sources loaded from the same file or
+     *        from a file with the same content, in all the mixers. Call before loading the data.
+     */
+    void set_shared(bool enable);
+    /**
+     * @brief Use decoded PCM data (interleaved) instead of a WAVE file
+     * @param data pcm data - may be shared
+     * @param format sample format of the data
+     * @param rate sample rate
+     * @param channels channels count
+     * @param channel_size size of one channel (bytes)
+     */
+    bool set_pcm(AssetCache::Data data, AuFormat format, int rate, int channels, int channel_size);
+    /**
+     * @brief Play PCM data (interleaved, little-endian) stored in a mapped file (sound bank entry)
+     * @param file the mapped file - kept while the source is alive
+     * @param offset offset of the data in the file
+     * @param size data size (bytes)
+     * @return false if the data is not in the file
+     */
+    bool set_mapped(std::shared_ptr<const MappedFile> file, uint64_t offset, uint64_t size,
+                    AuFormat format, int rate, int channels, int channel_size);
+    /**
+     * @brief Set the loop points (samples) - after the data is loaded
+     * @return false if they are not in the data
+     */
+    bool set_loop_points(int64_t start, int64_t end);
+    bool get_loop_points(int64_t &start, int64_t &end) const override;
+    size_t memory_size() const override;
 
     /* create a SamplePCM associated with this Source */
-    virtual std::unique_ptr<Sample> create_sample() override = 0;
+    virtual std::unique_ptr<Sample> create_sample(bool loop = false) override = 0;
 };
 
 
@@ -169,7 +275,7 @@ public:
 class SourcePCMF : public SourcePCM
 {
     /** Function pointer typedef for reading the sources */
-    using SourceReader = std::function<int32_t(int32_t *, int32_t, double&)>;
+    using SourceReader = std::function<int32_t(int32_t *, int32_t, double&, bool)>;
 
     /** step of the Sample */
     double sample_step;
@@ -192,17 +298,32 @@ class SourcePCMF : public SourcePCM
      * @param out_buffer mixer output buffer
      * @param sample_count number of output samples to process (buffer must be filled with sample_count x nb_mixer_channels elements)
      * @param sample_idx
-     * @param sample_frac
+     * @param loop the loop end wraps to the loop start (no partial read)
      * @return
      */
-    template <bool STEREO_INPUT, bool STEREO_OUTPUT>
-    int32_t read(int32_t *out_buffer, int32_t sample_count, double &sample_idx) const;
+    template <Storage STORAGE, bool STEREO_INPUT, bool STEREO_OUTPUT>
+    int32_t read(int32_t *out_buffer, int32_t sample_count, double &sample_idx, bool loop) const;
+
+    /**
+     * @brief Interpolate between the samples a and b, write the output sample(s)
+     * @return out after the written sample
+     */
+    template <Storage STORAGE, bool STEREO_INPUT, bool STEREO_OUTPUT>
+    int32_t *interpolate(int32_t *out, const char *a, const char *b, double alpha) const;
+
+    /** value of one channel in the mixer format */
+    template <Storage STORAGE>
+    int32_t fetch(const char *data) const;
+
+    /** select the read kernel for the storage and the channels */
+    template <Storage STORAGE>
+    void bind_read();
 
     friend class SamplePCMF;
 
 public:
     /* create a SamplePCM associated with this Source */
-    std::unique_ptr<Sample> create_sample() override;
+    std::unique_ptr<Sample> create_sample(bool loop = false) override;
 };
 
 class SamplePCMF : public Sample
@@ -213,11 +334,15 @@ class SamplePCMF : public Sample
     /** sample index */
     double sample_idx = 0;
 
+    /** played in a loop (mixer) */
+    std::atomic<bool> looping {false};
+
 public:
     SamplePCMF(const SourcePCMF &s);
     int32_t read(int32_t *buffer, int32_t sample_count) override;
     void seek(long pos) override;
     void seek_time(double pos) override;
+    void set_loop(bool loop) override;
 
     /** duration in seconds */
     double sample_time() const;
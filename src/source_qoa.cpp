@@ -0,0 +1,253 @@
+/**
+ * @file source_qoa.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "source_qoa.hpp"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#ifdef DEBUG
+#include <iostream>
+#endif
+
+namespace majimix {
+
+/* ---------------------- QOA format ----------------------------- */
+
+/*
+ * file   : "qoaf", number of frames (per channel, u32) - 0 : unknown (streaming)
+ * frame  : channels (u8), rate (u24), frames (u16), frame size (u16),
+ *          LMS state of each channel (4 history and 4 weights, s16),
+ *          the slices, one slice of each channel in turn
+ * slice  : scale factor (4 bits), 20 quantized residuals (3 bits)
+ * all the values are big endian
+ */
+static constexpr int qoa_slice_len = 20;
+static constexpr int qoa_frame_len = 256 * qoa_slice_len;
+/* the samples decode the frames by blocks of 16 slices (320 frames) */
+static constexpr int qoa_block_slices = 16;
+static constexpr int qoa_frame_blocks = 256 / qoa_block_slices;
+static constexpr int qoa_max_channels = 8;
+
+/* dequantized residuals : scale factor round((s + 1) ^ 2.75) x {0.75, -0.75, 2.5, -2.5, 4.5, -4.5, 7, -7} */
+static const int32_t qoa_dequant[16][8] = {
+	{1, -1, 3, -3, 5, -5, 7, -7},
+	{5, -5, 18, -18, 32, -32, 49, -49},
+	{16, -16, 53, -53, 95, -95, 147, -147},
+	{34, -34, 113, -113, 203, -203, 315, -315},
+	{63, -63, 210, -210, 378, -378, 588, -588},
+	{104, -104, 345, -345, 621, -621, 966, -966},
+	{158, -158, 528, -528, 950, -950, 1477, -1477},
+	{228, -228, 760, -760, 1368, -1368, 2128, -2128},
+	{316, -316, 1053, -1053, 1895, -1895, 2947, -2947},
+	{422, -422, 1405, -1405, 2529, -2529, 3934, -3934},
+	{548, -548, 1828, -1828, 3290, -3290, 5117, -5117},
+	{696, -696, 2320, -2320, 4176, -4176, 6496, -6496},
+	{868, -868, 2893, -2893, 5207, -5207, 8099, -8099},
+	{1064, -1064, 3548, -3548, 6386, -6386, 9933, -9933},
+	{1286, -1286, 4288, -4288, 7718, -7718, 12005, -12005},
+	{1536, -1536, 5120, -5120, 9216, -9216, 14336, -14336},
+};
+
+static uint64_t read_u64(const unsigned char *p)
+{
+	uint64_t v = 0;
+	for(int i = 0; i < 8; ++i)
+		v = v << 8 | p[i];
+	return v;
+}
+
+static size_t qoa_frame_size(int channels, int frames)
+{
+	return 8 + 16 * channels + 8 * channels * static_cast<size_t>((frames + qoa_slice_len - 1) / qoa_slice_len);
+}
+
+
+/* ---------------------- SourceQOA ----------------------------- */
+
+bool SourceQOA::test_qoa(const std::string &filename)
+{
+	std::ifstream stream(filename, std::ios::binary);
+	char magic[4];
+	return stream.read(magic, sizeof magic) && std::memcmp(magic, "qoaf", 4) == 0;
+}
+
+bool SourceQOA::load(const std::string &filename)
+{
+	auto load = [&filename](std::vector<char> &bytes) {
+		std::ifstream in(filename, std::ios::binary);
+		in.seekg(0, std::ios::end);
+		auto size = in.tellg();
+		if(!in || size <= 0)
+			return false;
+		bytes.resize(static_cast<size_t>(size));
+		in.seekg(0);
+		in.read(bytes.data(), size);
+		return static_cast<bool>(in);
+	};
+	data = shared ? AssetCache::instance().get(filename, AssetCache::Content::file, load) : AssetCache::load(load);
+	if(!data || !parse())
+	{
+		data.reset();
+		return false;
+	}
+	this->filename = filename;
+#ifdef DEBUG
+	std::cout << filename << " : QOA, " << size << " frames, " << channels << " channels, " << sample_rate << " Hz, "
+	          << frame_offsets.size() << " QOA frames\n";
+#endif
+	return true;
+}
+
+bool SourceQOA::parse()
+{
+	const auto *p = reinterpret_cast<const unsigned char *>(data->data());
+	const size_t length = data->size();
+	if(length < 8 || std::memcmp(p, "qoaf", 4) != 0)
+		return false;
+	const uint32_t header_frames = static_cast<uint32_t>(read_u64(p) & 0xFFFFFFFF);
+
+	// the frames are read up to the first invalid one (truncated file) : all full but the last one
+	frame_offsets.clear();
+	int frame_channels = 0;
+	int frame_rate = 0;
+	int last_frames = qoa_frame_len;
+	int64_t total = 0;
+	size_t offset = 8;
+	while(offset + 8 <= length && last_frames == qoa_frame_len)
+	{
+		const uint64_t header = read_u64(p + offset);
+		const int ch     = static_cast<int>(header >> 56);
+		const int rate   = static_cast<int>((header >> 32) & 0xFFFFFF);
+		const int frames = static_cast<int>((header >> 16) & 0xFFFF);
+		const size_t frame_size = header & 0xFFFF;
+		if(!ch || ch > qoa_max_channels || !rate || !frames || frames > qoa_frame_len
+		   || frame_size != qoa_frame_size(ch, frames) || frame_size > length - offset
+		   || (frame_channels && (ch != frame_channels || rate != frame_rate)))
+			break;
+		frame_channels = ch;
+		frame_rate = rate;
+		last_frames = frames;
+		frame_offsets.push_back(offset);
+		total += frames;
+		offset += frame_size;
+	}
+	if(header_frames)
+		total = std::min<int64_t>(total, header_frames);
+	if(frame_offsets.empty() || total <= 0 || total > INT32_MAX)
+		return false;
+
+	sample_rate  = frame_rate;
+	channels     = frame_channels;
+	block_frames = qoa_block_slices * qoa_slice_len;
+	size         = static_cast<int32_t>(total);
+	frame_offsets.resize((total + qoa_frame_len - 1) / qoa_frame_len);
+	return true;
+}
+
+void SourceQOA::set_shared(bool enable)
+{
+	shared = enable;
+}
+
+void SourceQOA::decode_block(int32_t block, int32_t *out, DecoderState &state) const
+{
+	const int32_t frame = block / qoa_frame_blocks;
+	const int sub_block = block % qoa_frame_blocks;
+	const auto *p = reinterpret_cast<const unsigned char *>(data->data()) + frame_offsets[frame] + 8;
+	const int shift = mixer_bits == 24 ? 8 : 0;
+
+	// LMS predictor of each channel (4 history values then 4 weights) : read from the frame header,
+	// or the state after the previous block
+	int32_t *lms = state.values.data();
+	int first = sub_block;
+	if(!sub_block || state.next_block != block)
+	{
+		for(int c = 0; c < channels; ++c)
+		{
+			uint64_t history = read_u64(p + 16 * c);
+			uint64_t weights = read_u64(p + 16 * c + 8);
+			for(int i = 0; i < 4; ++i)
+			{
+				lms[8 * c + i]     = static_cast<int16_t>(history >> 48);
+				lms[8 * c + 4 + i] = static_cast<int16_t>(weights >> 48);
+				history <<= 16;
+				weights <<= 16;
+			}
+		}
+		// seek : the previous blocks of the frame are decoded (in out) to get the state
+		first = 0;
+	}
+	p += 16 * channels;
+
+	for(int b = first; b <= sub_block; ++b)
+	{
+		const int frames = frames_in_block(frame * qoa_frame_blocks + b);
+		const unsigned char *slices = p + static_cast<size_t>(b) * qoa_block_slices * 8 * channels;
+		for(int index = 0; index < frames; index += qoa_slice_len)
+		{
+			const int slice_frames = std::min(qoa_slice_len, frames - index);
+			for(int c = 0; c < channels; ++c, slices += 8)
+			{
+				int32_t *history = lms + 8 * c;
+				int32_t *weights = history + 4;
+				uint64_t slice = read_u64(slices);
+				const int32_t *dequant = qoa_dequant[slice >> 60];
+				int32_t *o = out + index * channels + c;
+				for(int i = 0; i < slice_frames; ++i)
+				{
+					int32_t prediction = (weights[0] * history[0] + weights[1] * history[1]
+					                    + weights[2] * history[2] + weights[3] * history[3]) >> 13;
+					int32_t residual = dequant[(slice >> 57) & 7];
+					int32_t sample = std::clamp(prediction + residual, -32768, 32767);
+					slice <<= 3;
+
+					// LMS update : the sign of the history selects the weight adjustment
+					int32_t delta = residual >> 4;
+					for(int k = 0; k < 4; ++k)
+						weights[k] += history[k] < 0 ? -delta : delta;
+					history[0] = history[1];
+					history[1] = history[2];
+					history[2] = history[3];
+					history[3] = sample;
+
+					*o = sample * (1 << shift);
+					o += channels;
+				}
+			}
+		}
+	}
+	state.next_block = block + 1;
+}
+
+size_t SourceQOA::memory_size() const
+{
+	return data ? data->size() : 0;
+}
+
+}
@@ -0,0 +1,81 @@
+/**
+ * @file source_qoa.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SOURCE_QOA_HPP_
+#define SOURCE_QOA_HPP_
+
+#include "source_block.hpp"
+#include "asset_cache.hpp"
+#include <string>
+#include <vector>
+
+namespace majimix 
+{
+
+/**
+ * @class SourceQOA
+ * @brief QOA (Quite OK Audio) file : the file (3.2 bits per sample) is kept in memory and the
+ *        samples decode it by blocks of 16 slices (320 frames) while they play.
+ *
+ * The QOA frames (5120 frames, 256 slices of 20 frames) are independent : each one starts
+ * with the LMS predictors state. The blocks of a frame are decoded in sequence with the state
+ * kept by the sample, a seek decodes the frame from its start up to the block of the position.
+ */
+class SourceQOA : public SourceBlock
+{
+    std::string filename;
+
+    /** the whole file - shared with the other sources of the same file */
+    AssetCache::Data data;
+    /** the file is loaded through the AssetCache */
+    bool shared = false;
+
+    /** position of each frame in the file */
+    std::vector<size_t> frame_offsets;
+
+    /** check the frames headers and set the format */
+    bool parse();
+
+public:
+    /** test if the file seems to be a QOA file */
+    static bool test_qoa(const std::string &filename);
+
+    /**
+     * @brief Load a QOA file
+     * @return false if the file is not a valid QOA file
+     */
+    bool load(const std::string &filename);
+    /** the file is shared (AssetCache) - call before load */
+    void set_shared(bool enable);
+
+    void decode_block(int32_t block, int32_t *out, DecoderState &state) const override;
+    size_t memory_size() const override;
+};
+
+}
+
+#endif
@@ -26,8 +26,14 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 #include "source_vorbis.hpp"
-#include "converters.hpp"
+#include "profiler.hpp"
+#include "load_pool.hpp"
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <thread>
 #include <vector>
 #include <iostream>
 
@@ -63,81 +69,635 @@ static long ogg_tell(void* dataSource) {
     return static_cast<long>(position);
 }
 
-bool SourceVorbis::set_file(const std::string& filename)
+// In memory Vorbis Callbacks
+
+static size_t ogg_memory_read(void* buffer, size_t elementSize, size_t elementCount, void* dataSource) {
+    assert(elementSize == 1);
+
+    OggMemory& memory = *static_cast<OggMemory*>(dataSource);
+    const size_t size = memory.size;
+    const size_t count = std::min(elementCount, size - std::min(memory.position, size));
+    std::copy_n(memory.data.get() + memory.position, count, static_cast<char*>(buffer));
+    memory.position += count;
+    return count;
+}
+
+static int ogg_memory_seek(void* dataSource, ogg_int64_t offset, int origin) {
+    OggMemory& memory = *static_cast<OggMemory*>(dataSource);
+    ogg_int64_t base = origin == SEEK_SET ? 0 : origin == SEEK_CUR ? static_cast<ogg_int64_t>(memory.position) : static_cast<ogg_int64_t>(memory.size);
+    if(base + offset < 0)
+        return -1;
+    memory.position = static_cast<size_t>(base + offset);
+    return 0;
+}
+
+static long ogg_memory_tell(void* dataSource) {
+    return static_cast<long>(static_cast<OggMemory*>(dataSource)->position);
+}
+
+static const ov_callbacks ogg_memory_callbacks {ogg_memory_read, ogg_memory_seek, nullptr, ogg_memory_tell};
+
+bool SourceVorbis::set_file(const std::string& filename, bool in_memory)
 {
-    std::ifstream stream(filename, std::ios::binary);
+	if(in_memory)
+	{
+		// the whole compressed file, shared by the samples
+		auto load = [&filename](std::vector<char> &bytes) {
+			std::ifstream in(filename, std::ios::binary);
+			in.seekg(0, std::ios::end);
+			auto size = in.tellg();
+			if(!in || size <= 0)
+				return false;
+			bytes.resize(static_cast<size_t>(size));
+			in.seekg(0);
+			in.read(bytes.data(), size);
+			return static_cast<bool>(in);
+		};
+		AssetCache::Data bytes;
+		if(shared)
+			bytes = AssetCache::instance().get(filename, AssetCache::Content::file, load);
+		else
+			bytes = AssetCache::load(load);
+		if(!bytes)
+			return false;
+		data_mapped = false;
+		return set_memory(filename, std::shared_ptr<const char>(bytes, bytes->data()), bytes->size());
+	}
+
+	std::ifstream stream(filename, std::ios::binary);
 	OggVorbis_File file;
 	int result = ov_test_callbacks(&stream, &file, nullptr, 0, {ogg_read, ogg_seek, nullptr, ogg_tell});
 	ov_clear(&file);
 	if(!result)
 	{
         this->filename = filename;
+        prepare_loop();
+        fill_decoder_pool();
     }
     return !result;
 }
 
+bool SourceVorbis::set_mapped(const std::string &name, std::shared_ptr<const char> bytes, size_t size)
+{
+	data_mapped = true;
+	return set_memory(name, std::move(bytes), size);
+}
+
+bool SourceVorbis::set_memory(const std::string &filename, std::shared_ptr<const char> bytes, size_t size)
+{
+	OggVorbis_File file;
+	OggMemory memory {bytes, size, 0};
+	int result = ov_test_callbacks(&memory, &file, nullptr, 0, ogg_memory_callbacks);
+	ov_clear(&file);
+	if(!result)
+	{
+		data = std::move(bytes);
+		data_size = size;
+		this->filename = filename;
+		prepare_loop();
+		fill_decoder_pool();
+	}
+	return !result;
+}
+
+SourceVorbis::~SourceVorbis()
+{
+	index_cancel = true;
+	if(index_thread.joinable())
+		index_thread.join();
+}
+
+/* ---------------------- seek index ----------------------------- */
+
+bool VorbisSeekIndex::seek(OggVorbis_File &file, int64_t position) const
+{
+	if(entries.empty() || position < 0)
+		return false;
+
+	// last page ending at or before position : the decoding resumes at its beginning, before position
+	auto it = std::upper_bound(entries.begin(), entries.end(), position, [](int64_t p, const Entry &e) { return p < e.granule; });
+	if(it != entries.begin())
+		--it;
+	if(ov_raw_seek(&file, it->offset))
+		return false;
+	ogg_int64_t current = ov_pcm_tell(&file);
+	if(current < 0 || current > position)
+		return false;
+
+	// decode (and drop) up to position : less than two pages
+	float **pcm;
+	int section;
+	while(current < position)
+	{
+		long frames = ov_read_float(&file, &pcm, static_cast<int>(std::min<ogg_int64_t>(position - current, 4096)), &section);
+		if(frames == OV_HOLE)
+			continue;
+		if(frames <= 0)
+			return false;
+		current += frames;
+	}
+	return true;
+}
+
+/* read size bytes at offset - returns the count */
+using ReadAt = std::function<size_t(uint64_t offset, char *out, size_t size)>;
+
+/* Ogg pages granule positions - empty if the file is chained (several logical bitstreams) */
+static bool scan_ogg_pages(const ReadAt &read_at, const std::atomic<bool> &cancel, std::vector<VorbisSeekIndex::Entry> &entries)
+{
+	// page header : "OggS" version type granule(8) serial(4) sequence(4) crc(4) segments(1) + lacing values
+	constexpr size_t header_size = 27;
+	unsigned char header[header_size + 255];
+	uint64_t offset = 0;
+	uint32_t first_serial = 0;
+	bool first_page = true;
+
+	while(!cancel)
+	{
+		if(read_at(offset, reinterpret_cast<char *>(header), header_size) < header_size)
+			break;
+		if(std::memcmp(header, "OggS", 4))
+		{
+			// lost sync : next capture pattern
+			char buffer[4096];
+			size_t n = read_at(offset + 1, buffer, sizeof(buffer));
+			if(n < 4)
+				break;
+			size_t i = 0;
+			while(i + 4 <= n && std::memcmp(buffer + i, "OggS", 4))
+				++i;
+			offset += 1 + (i + 4 <= n ? i : n - 3);
+			continue;
+		}
+
+		size_t segments = header[26];
+		if(read_at(offset + header_size, reinterpret_cast<char *>(header) + header_size, segments) < segments)
+			break;
+		size_t body = 0;
+		for(size_t i = 0; i < segments; ++i)
+			body += header[header_size + i];
+
+		int64_t granule = 0;
+		uint32_t serial = 0;
+		for(int i = 7; i >= 0; --i)
+			granule = (granule << 8) | header[6 + i];
+		for(int i = 3; i >= 0; --i)
+			serial = (serial << 8) | header[14 + i];
+
+		if(first_page)
+		{
+			first_serial = serial;
+			first_page = false;
+		}
+		else if(serial != first_serial)
+		{
+			// chained file : granules restart with each link
+			entries.clear();
+			return false;
+		}
+
+		// -1 : no packet ends on this page, 0 : headers
+		if(granule > 0)
+			entries.push_back({granule, static_cast<int64_t>(offset)});
+		offset += header_size + segments + body;
+	}
+	return !cancel;
+}
+
+/* <file>.idx : magic, file size, file date, entry count, entries */
+static constexpr char index_magic[8] = {'M', 'J', 'X', 'I', 'D', 'X', '1', '\0'};
+
+static bool file_signature(const std::string &filename, uint64_t &size, int64_t &date)
+{
+	std::error_code ec;
+	size = std::filesystem::file_size(filename, ec);
+	if(ec)
+		return false;
+	auto time = std::filesystem::last_write_time(filename, ec);
+	if(ec)
+		return false;
+	date = static_cast<int64_t>(time.time_since_epoch().count());
+	return true;
+}
+
+static bool load_seek_index(const std::string &filename, VorbisSeekIndex &index)
+{
+	uint64_t size, count;
+	int64_t date;
+	if(!file_signature(filename, size, date))
+		return false;
+	std::ifstream in(filename + ".idx", std::ios::binary);
+	char magic[8];
+	uint64_t index_size;
+	int64_t index_date;
+	in.read(magic, sizeof(magic));
+	in.read(reinterpret_cast<char *>(&index_size), sizeof(index_size));
+	in.read(reinterpret_cast<char *>(&index_date), sizeof(index_date));
+	in.read(reinterpret_cast<char *>(&count), sizeof(count));
+	if(!in || std::memcmp(magic, index_magic, sizeof(magic)) || index_size != size || index_date != date
+	   || count > size / 27)
+		return false;
+	index.entries.resize(static_cast<size_t>(count));
+	in.read(reinterpret_cast<char *>(index.entries.data()), static_cast<std::streamsize>(count * sizeof(VorbisSeekIndex::Entry)));
+	return static_cast<bool>(in);
+}
+
+static void save_seek_index(const std::string &filename, const VorbisSeekIndex &index)
+{
+	uint64_t size, count = index.entries.size();
+	int64_t date;
+	if(!file_signature(filename, size, date))
+		return;
+	// not an error if the directory is read only
+	std::ofstream out(filename + ".idx", std::ios::binary | std::ios::trunc);
+	out.write(index_magic, sizeof(index_magic));
+	out.write(reinterpret_cast<const char *>(&size), sizeof(size));
+	out.write(reinterpret_cast<const char *>(&date), sizeof(date));
+	out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+	out.write(reinterpret_cast<const char *>(index.entries.data()), static_cast<std::streamsize>(count * sizeof(VorbisSeekIndex::Entry)));
+}
+
+void SourceVorbis::build_seek_index(bool persistent)
+{
+	if(filename.empty())
+		return;
+	index_cancel = true;
+	if(index_thread.joinable())
+		index_thread.join();
+	index_cancel = false;
+
+	index_thread = std::thread([this, persistent, filename = filename, data = data, data_size = data_size]() {
+		auto index = std::make_shared<VorbisSeekIndex>();
+		if(!persistent || !load_seek_index(filename, *index))
+		{
+			bool complete;
+			if(data)
+			{
+				complete = scan_ogg_pages([&data, data_size](uint64_t offset, char *out, size_t size) {
+					size_t start = static_cast<size_t>(std::min<uint64_t>(offset, data_size));
+					size = std::min(size, data_size - start);
+					std::copy_n(data.get() + start, size, out);
+					return size;
+				}, index_cancel, index->entries);
+			}
+			else
+			{
+				std::ifstream stream(filename, std::ios::binary);
+				complete = scan_ogg_pages([&stream](uint64_t offset, char *out, size_t size) {
+					stream.seekg(static_cast<std::streamoff>(offset));
+					stream.read(out, static_cast<std::streamsize>(size));
+					auto count = stream.gcount();
+					stream.clear();
+					return static_cast<size_t>(count);
+				}, index_cancel, index->entries);
+			}
+			if(!complete || index->entries.empty())
+				return;
+			if(persistent)
+				save_seek_index(filename, *index);
+		}
+#ifdef DEBUG
+		std::cout << "seek index " << filename << " : " << index->entries.size() << " pages\n";
+#endif
+		std::atomic_store(&seek_index, std::shared_ptr<const VorbisSeekIndex>(std::move(index)));
+	});
+}
+
+/* open a decoder on the file or on its copy in memory */
+static int open_ogg(const std::string &filename, const std::shared_ptr<const char> &data, size_t data_size,
+                    std::ifstream &stream, OggMemory &memory, OggVorbis_File &file)
+{
+	if(data)
+	{
+		memory.data = data;
+		memory.size = data_size;
+		return ov_open_callbacks(&memory, &file, nullptr, 0, ogg_memory_callbacks);
+	}
+	stream.open(filename, std::ios::binary);
+	if(!stream)
+		return OV_EREAD;
+	return ov_open_callbacks(&stream, &file, nullptr, 0, {ogg_read, ogg_seek, nullptr, ogg_tell});
+}
+
+void SourceVorbis::set_loop_head(int ms)
+{
+	loop_head_ms = std::max(ms, 0);
+}
+
+bool SourceVorbis::get_loop_points(int64_t &start, int64_t &end) const
+{
+	if(!loop_end)
+		return false;
+	start = loop_start;
+	end = loop_end;
+	return true;
+}
+
+size_t SourceVorbis::memory_size() const
+{
+	// the mapped bank is in the page cache
+	return (data && !data_mapped ? data_size : 0) + head.size() * sizeof(float);
+}
+
+void SourceVorbis::prepare_loop()
+{
+	loop_start = 0;
+	loop_end = 0;
+	head.clear();
+	head_start = 0;
+	head_frames = 0;
+
+	std::ifstream stream;
+	OggMemory memory;
+	OggVorbis_File file;
+	if(open_ogg(filename, data, data_size, stream, memory, file) < 0)
+		return;
+	// chained files : the format of the head could differ from the end of the stream
+	if(ov_streams(&file) == 1)
+	{
+		// loop points (samples) : LOOPSTART with LOOPLENGTH or LOOPEND
+		vorbis_comment *vc = ov_comment(&file, -1);
+		const char *start = vorbis_comment_query(vc, "LOOPSTART", 0);
+		const char *length = vorbis_comment_query(vc, "LOOPLENGTH", 0);
+		const char *end = vorbis_comment_query(vc, "LOOPEND", 0);
+		ogg_int64_t total = ov_pcm_total(&file, -1);
+		if(start && (length || end))
+		{
+			int64_t s = std::strtoll(start, nullptr, 10);
+			int64_t e = length ? s + std::strtoll(length, nullptr, 10) : std::strtoll(end, nullptr, 10);
+			if(s >= 0 && s < e && e <= total)
+			{
+				loop_start = s;
+				loop_end = e;
+			}
+		}
+#ifdef DEBUG
+		if(loop_end)
+			std::cout << "loop " << loop_start << " - " << loop_end << "\n";
+#endif
+
+		// with loop points, the loop start is always in memory : the wrap needs no seek
+		int ms = loop_end ? std::max(loop_head_ms, default_loop_head_ms) : loop_head_ms;
+		if(ms > 0 && (!loop_start || !ov_pcm_seek(&file, loop_start)))
+		{
+			vorbis_info *vi = ov_info(&file, -1);
+			int channels = vi->channels;
+			int64_t frames = std::min<int64_t>(static_cast<int64_t>(vi->rate) * ms / 1000, (loop_end ? loop_end : total) - loop_start);
+			head_start = loop_start;
+			head.reserve(static_cast<size_t>(frames * channels));
+			float **pcm;
+			int section;
+			while(head_frames < frames)
+			{
+				long read_val = ov_read_float(&file, &pcm, static_cast<int>(std::min<int64_t>(frames - head_frames, 4096)), &section);
+				if(read_val == OV_HOLE)
+					continue;
+				if(read_val <= 0)
+					break;
+				for(long i = 0; i < read_val; ++i)
+					for(int c = 0; c < channels; ++c)
+						head.push_back(std::clamp(pcm[c][i], -1.f, 1.f));
+				head_frames += read_val;
+			}
+		}
+	}
+	ov_clear(&file);
+}
+
+/* decode up to size bytes (16 bits PCM) from the current position - returns the decoded size */
+static size_t decode_pcm(OggVorbis_File &file, char *out, size_t size)
+{
+	size_t length = 0;
+	int section;
+	while(length < size)
+	{
+		long read_val = ov_read(&file, out + length, static_cast<int>(std::min<size_t>(size - length, 4096)), 0, 2, 1, &section);
+		if(read_val > 0)
+			length += static_cast<size_t>(read_val);
+		else if(read_val != OV_HOLE)
+			break;
+	}
+	return length;
+}
+
+bool SourceVorbis::decode_to_pcm(int max_ms, int max_bytes, AssetCache::Data &pcm, int &rate, int &channels) const
+{
+	if((max_ms <= 0 && max_bytes <= 0) || filename.empty())
+		return false;
+
+	std::ifstream stream;
+	OggMemory memory;
+	OggVorbis_File file;
+	if(open_ogg(filename, data, data_size, stream, memory, file) < 0)
+		return false;
+
+	bool done = false;
+	vorbis_info *vi = ov_info(&file, -1);
+	rate = vi->rate;
+	channels = vi->channels;
+	bool single_format = true;
+	for(int i = 1; i < ov_streams(&file); ++i)
+		single_format = single_format && ov_info(&file, i)->rate == rate && ov_info(&file, i)->channels == channels;
+
+	const ogg_int64_t frames = ov_pcm_total(&file, -1);
+	const ogg_int64_t frame_size = 2 * channels;
+	const ogg_int64_t bytes = frames * frame_size;
+	const bool short_enough = (max_ms > 0 && frames * 1000 < static_cast<ogg_int64_t>(max_ms) * rate)
+	                       || (max_bytes > 0 && bytes < max_bytes);
+	if(single_format && frames > 0 && short_enough)
+	{
+		auto decode = [&](std::vector<char> &pcm) {
+			pcm.resize(static_cast<size_t>(bytes));
+
+			// long files : segments decoded concurrently by independent decoders, ov_pcm_seek is sample accurate
+			// (sequential on a LoadPool worker : the loads are already run in parallel)
+			constexpr ogg_int64_t min_segment_seconds = 2;
+			unsigned int segments = 1;
+			if(ov_seekable(&file) && !LoadPool::is_worker())
+				segments = static_cast<unsigned int>(std::clamp<ogg_int64_t>(frames / (min_segment_seconds * rate), 1,
+				                                                              std::max(1u, std::thread::hardware_concurrency())));
+
+			std::vector<char> complete(segments, 0);
+			auto decode_segment = [&](unsigned int i, OggVorbis_File &f) {
+				ogg_int64_t first = frames * i / segments;
+				ogg_int64_t last = frames * (i + 1) / segments;
+				size_t size = static_cast<size_t>((last - first) * frame_size);
+				if(i == 0 || ov_pcm_seek(&f, first) == 0)
+					complete[i] = decode_pcm(f, pcm.data() + first * frame_size, size) == size;
+			};
+
+			std::vector<std::thread> workers;
+			for(unsigned int i = 1; i < segments; ++i)
+				workers.emplace_back([&, i] {
+					std::ifstream segment_stream;
+					OggMemory segment_memory;
+					OggVorbis_File segment_file;
+					if(open_ogg(filename, data, data_size, segment_stream, segment_memory, segment_file) >= 0)
+					{
+						decode_segment(i, segment_file);
+						ov_clear(&segment_file);
+					}
+				});
+			decode_segment(0, file);
+			for(auto &w : workers)
+				w.join();
+
+			if(std::find(complete.begin(), complete.end(), 0) == complete.end())
+				return true;
+
+			// truncated file or seek failure : sequential decoding of what can be decoded
+			ov_pcm_seek(&file, 0);
+			size_t length = decode_pcm(file, pcm.data(), pcm.size());
+			pcm.resize(length);
+			return length > 0;
+		};
+
+		// the file is only decoded by the first source
+		if(shared)
+			pcm = AssetCache::instance().get(filename, AssetCache::Content::vorbis_pcm, decode);
+		else
+			pcm = AssetCache::load(decode);
+		done = pcm != nullptr;
+	}
+	ov_clear(&file);
+	return done;
+}
+
+void SourceVorbis::set_shared(bool enable)
+{
+	shared = enable;
+}
+
+void SourceVorbis::set_decode_ahead(bool enable)
+{
+	decode_ahead = enable;
+}
+
 void SourceVorbis::set_output_format(int samples_per_sec, int channels, int bits)
 {
 	mixer_rate = samples_per_sec;
 	mixer_channels = channels;
 	mixer_bits = bits;
-	decoder = bits == 16 ? converters::in_to_i16_le<2> : converters::in_to_i24_le<2>;
+	scale = bits == 16 ? 32767.f : 8388607.f;
+
+	// the pooled decoders were configured for the previous format
+	decoders.clear();
+	fill_decoder_pool();
+}
+
+void SourceVorbis::set_decoder_pool_size(int count)
+{
+	decoder_pool_size = static_cast<size_t>(std::max(count, 0));
+	if(decoders.size() > decoder_pool_size)
+		decoders.resize(decoder_pool_size);
+	fill_decoder_pool();
+}
+
+void SourceVorbis::fill_decoder_pool()
+{
+	if(!mixer_rate || filename.empty())
+		return;
+	decoders.reserve(decoder_pool_size);
+	while(decoders.size() < decoder_pool_size)
+		decoders.push_back(std::make_unique<SampleVorbis>(*this, false, true));
+}
+
+std::unique_ptr<Sample> SourceVorbis::create_sample(bool loop)
+{
+	if(!decoders.empty())
+	{
+		auto sample = std::move(decoders.back());
+		decoders.pop_back();
+		sample->start(loop);
+		return sample;
+	}
+	return std::make_unique<SampleVorbis>(*this, loop);
 }
 
-std::unique_ptr<Sample> SourceVorbis::create_sample()
+bool SourceVorbis::recycles_samples() const
 {
-	return std::make_unique<SampleVorbis>(*this);
+	return decoders.size() < decoder_pool_size;
+}
+
+void SourceVorbis::recycle_sample(std::unique_ptr<Sample> sample)
+{
+	// the samples of this source are SampleVorbis
+	if(sample && decoders.size() < decoder_pool_size)
+	{
+		decoders.emplace_back(static_cast<SampleVorbis *>(sample.release()));
+		decoders.back()->rewind();
+	}
 }
 
 
-SampleVorbis::SampleVorbis(const SourceVorbis &s)
+SampleVorbis::SampleVorbis(const SourceVorbis &s, bool loop, bool in_pool)
 : source {&s},
   sample_rate {0},
   sample_size {0},
   channels {0},
-  channel_size {0},
   sample_step {0},
-  current_section{0},
-  last_section{-1},
-  min_buffer_data_size{0},
-  max_buffer_idx{0},
   sample_pos{0.0},
-  buffer_read_length{0}
+  buffer_frames{0},
+  ring {ring_size}
 {
-	stream.open(source->filename, std::ios::binary);
-	if(stream)
+	// the loop end is known (or the decoding waits at the loop end) before the first blocks are decoded
+	looping.store(loop, std::memory_order_relaxed);
+	parked.store(in_pool, std::memory_order_relaxed);
+	int result = -1;
+	if(source->data)
 	{
-		int result = ov_open_callbacks(&stream, &file, nullptr, 0, {ogg_read, ogg_seek, nullptr, ogg_tell});
-		if (result < 0) {
+		// no file access : the headers are parsed from the shared copy
+		memory.data = source->data;
+		memory.size = source->data_size;
+		result = ov_open_callbacks(&memory, &file, nullptr, 0, ogg_memory_callbacks);
+	}
+	else
+	{
+		stream.open(source->filename, std::ios::binary);
+		if(stream)
+			result = ov_open_callbacks(&stream, &file, nullptr, 0, {ogg_read, ogg_seek, nullptr, ogg_tell});
+	}
+	if (result < 0) {
 #ifdef DEBUG
-			std::cout << "Error opening file: " << result << std::endl;
+		std::cout << "Error opening file: " << result << std::endl;
 #endif
-			return;
-		}
+		return;
+	}
+	opened = true;
+	// stereo chunks : no allocation by the reader when it decodes (offline)
+	pending.reserve(decode_frames * 2);
 
 #ifdef DEBUG
-		if(ov_seekable(&file))
-		{
-			std::cout << "Input bitstream contained " <<  ov_streams(&file) <<" logical bitstream section(s).\n";
-			std::cout << "Total bitstream playing time: "<< (long)ov_time_total(&file,-1) <<" seconds\n\n";
-		}
-		else
-		{
-			std::cout << "Standard input was not seekable.\nFirst logical bitstream information:\n\n";
-		}
+	if(ov_seekable(&file))
+	{
+		std::cout << "Input bitstream contained " <<  ov_streams(&file) <<" logical bitstream section(s).\n";
+		std::cout << "Total bitstream playing time: "<< (long)ov_time_total(&file,-1) <<" seconds\n\n";
+	}
+	else
+	{
+		std::cout << "Standard input was not seekable.\nFirst logical bitstream information:\n\n";
+	}
 
-		for(int i=0 ; i < ov_streams(&file); i++)
-		{
-			//     if multistream - rate and channels can change
-			vorbis_info *vi = ov_info(&file,i);
-			std::cout <<"\tlogical bitstream section " << (i+1) <<" information:\n";
-			std::cout << "\t\t"<<vi->rate<<"Hz "<< vi->channels << " channels bitrate " << (ov_bitrate(&file,i)/1000) << "kbps serial number=" << ov_serialnumber(&file,i) <<"\n";
-			std::cout << "\t\tcompressed length: "<<(long)(ov_raw_total(&file,i))<<" bytes " << " play time: " << (long)ov_time_total(&file,i) <<"s\n";
-		}
+	for(int i=0 ; i < ov_streams(&file); i++)
+	{
+		//     if multistream - rate and channels can change
+		vorbis_info *vi = ov_info(&file,i);
+		std::cout <<"\tlogical bitstream section " << (i+1) <<" information:\n";
+		std::cout << "\t\t"<<vi->rate<<"Hz "<< vi->channels << " channels bitrate " << (ov_bitrate(&file,i)/1000) << "kbps serial number=" << ov_serialnumber(&file,i) <<"\n";
+		std::cout << "\t\tcompressed length: "<<(long)(ov_raw_total(&file,i))<<" bytes " << " play time: " << (long)ov_time_total(&file,i) <<"s\n";
+	}
 #endif
-		configure();
-		// initialized = true;
+	pooled = source->decode_ahead;
+	// the head is played from memory, the decoder continues after it
+	head_position = source->head_frames;
+	if(source->head_frames && !source->head_start)
+	{
+		head_position = 0;
+		decoder_seek = source->head_frames;
 	}
+	restart();
+	if(pooled)
+		StreamPool::instance().add(this);
 }
 
 SampleVorbis::~SampleVorbis()
@@ -145,33 +705,46 @@ SampleVorbis::~SampleVorbis()
 #ifdef DEBUG
 	std::cout << "~SampleVorbis()()\n";
 #endif
-	ov_clear(&file);
+	if(pooled)
+		StreamPool::instance().remove(this);
+	if(opened)
+		ov_clear(&file);
 }
 
-void SampleVorbis::configure()
+void SampleVorbis::configure(int rate, int channels)
 {
 	initialized = false;
 
-	/* Read file info */
-	vorbis_info* vorbisInfo = ov_info(&file, -1);
-	sample_rate = vorbisInfo->rate;
-	channels    = vorbisInfo->channels;
-	channel_size = 2;
-	sample_size = channel_size * channels;
+	sample_rate = rate;
+	this->channels = channels;
+	sample_size = static_cast<int>(sizeof(float)) * channels;
 	// sample_step = (static_cast<uint_fast64_t>(sample_rate) << FP_SHIFT) /  source->mixer_rate;
 	sample_step = static_cast<double>(sample_rate) / source->mixer_rate;
-	min_buffer_data_size = sample_size * 2;
-	max_buffer_idx = -1;
+
+	/* resampling kernel */
+	if(source->mixer_channels == 1)
+	{
+		if(channels > 1)
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<true, false>(out, count); };
+		else
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<false, false>(out, count); };
+	}
+	else
+	{
+		// we assume a stereo output : surround, 5.1, 7.1  - not supported (yet)
+		if(channels > 1)
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<true, true>(out, count); };
+		else
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<false, true>(out, count); };
+	}
 
 	initialized = true;
 
 #ifdef DEBUG
-	std::cout << "File info: " << vorbisInfo->rate << "Hz, " << vorbisInfo->channels << " channels\n";
 	std::cout << "configure :\n";
 	std::cout << "sampling_rate  : " << sample_rate << "\n";
 	std::cout << "sample_size    : " << sample_size << "\n";
 	std::cout << "channels       : " << channels << "\n";
-	std::cout << "channel_size   : " << channel_size << "\n";
 	std::cout << "mixer_rate     : " << source->mixer_rate << "\n";
 	std::cout << "mixer_bits     : " << source->mixer_bits << "\n";
 	std::cout << "mixer_channels : " << source->mixer_channels << "\n";
@@ -179,114 +752,412 @@ void SampleVorbis::configure()
 #endif
 }
 
-int32_t SampleVorbis::read(int32_t *out, int32_t sample_count)
+void SampleVorbis::restart(bool prefill)
 {
-	int32_t out_sample_count = 0;
-	bool done = false;
+	ring.clear();
+	pending.clear();
+	pending_offset = 0;
+	marker_read.store(0, std::memory_order_relaxed);
+	marker_write.store(0, std::memory_order_relaxed);
+	exhausted.store(false, std::memory_order_relaxed);
+	last_eof = false;
 
-	while(!done)
-	{
-		auto sample_idx = static_cast<int32_t>(sample_pos);
-		double alpha = sample_pos - sample_idx;
-		int32_t buffer_idx = sample_idx * sample_size;
+	vorbis_info *vi = ov_info(&file, -1);
+	decoder_rate = vi->rate;
+	decoder_channels = vi->channels;
+
+	buffer_frames = 0;
+	sample_pos = 0;
+	if(!initialized || sample_rate != decoder_rate || channels != decoder_channels)
+		configure(decoder_rate, decoder_channels);
 
-		if(buffer_idx > max_buffer_idx)
+	// the first blocks are available before the workers get the stream
+	if(pooled && prefill)
+		for(int i = 0; i < 4 && decode_ahead(); ++i);
+}
+
+float SampleVorbis::buffered() const
+{
+	if(exhausted.load(std::memory_order_relaxed) || held.load(std::memory_order_relaxed) || ring.space() < decode_size
+	   || marker_write.load(std::memory_order_relaxed) - marker_read.load(std::memory_order_relaxed) >= marker_count)
+		return 1.f;
+	return static_cast<float>(ring.size()) / ring.capacity();
+}
+
+bool SampleVorbis::decode_ahead()
+{
+	if(!opened || buffered() >= 1.f)
+		return false;
+
+	auto flush = [this]() {
+		pending_offset += ring.write(reinterpret_cast<const char *>(pending.data() + pending_offset),
+		                             (pending.size() - pending_offset) * sizeof(float)) / sizeof(float);
+		if(pending_offset == pending.size())
 		{
-			int32_t buffer_remaining = buffer_read_length - buffer_idx;
+			pending.clear();
+			pending_offset = 0;
+		}
+		last_eof = false;
+		return true;
+	};
 
-			if(buffer_remaining > 0)
-				std::copy(internal_buffer + buffer_idx, internal_buffer  + buffer_read_length, internal_buffer);
-			int32_t r = std::max(buffer_remaining, 0);
-			long read_val = ov_read(&file, internal_buffer + r, internal_buffer_size - r, 0, 2, 1, &current_section);
-			if(read_val == 0)
-			{
-				// EOF
-				done = true;
-				seek(0); // auto loop
-			}
-			else if(read_val > 0)
+	// a previous chunk did not fit (more channels than expected)
+	if(!pending.empty())
+		return flush();
+
+	// beginning of the stream : copied from the source head
+	if(head_position < source->head_frames)
+	{
+		size_t frame_size = sizeof(float) * decoder_channels;
+		auto frames = std::min<int64_t>({source->head_frames - head_position, decode_frames, static_cast<int64_t>(ring.space() / frame_size)});
+		ring.write(reinterpret_cast<const char *>(source->head.data() + head_position * decoder_channels), static_cast<size_t>(frames) * frame_size);
+		head_position += frames;
+		last_eof = false;
+		return true;
+	}
+	if(decoder_seek >= 0)
+	{
+		seek_decoder(decoder_seek);
+		decoder_seek = -1;
+	}
+
+	// loop end (looping sample) : the loop start follows from memory, no end of stream
+	// (parked in the pool : the decoding waits at the loop end for the loop state)
+	int max_frames = decode_frames;
+	const bool in_pool = parked.load(std::memory_order_relaxed);
+	if(source->loop_end && (in_pool || looping.load(std::memory_order_relaxed)))
+	{
+		ogg_int64_t position = ov_pcm_tell(&file);
+		if(position == source->loop_end)
+		{
+			if(in_pool)
 			{
-				if (current_section != last_section)
-				{
-					configure();
-					last_section = current_section;
-				}
-				int32_t obr = buffer_read_length - r;
-				buffer_read_length  = read_val + r;	
-				max_buffer_idx = buffer_read_length - min_buffer_data_size;
-
-				buffer_idx -= obr;
-				sample_idx = buffer_idx / sample_size;
-				sample_pos = sample_idx + alpha;				
+				held.store(true, std::memory_order_relaxed);
+				return false;
 			}
+			head_position = 0;
+			decoder_seek = source->head_start + source->head_frames;
+			return true;
 		}
+		if(position < source->loop_end)
+			max_frames = static_cast<int>(std::min<ogg_int64_t>(max_frames, source->loop_end - position));
+	}
 
-		if(buffer_idx <= max_buffer_idx)
+	float **pcm;
+	int section;
+	long frames;
+	{
+		MAJIMIX_PROFILE_SCOPE(vorbis_decode);
+		frames = ov_read_float(&file, &pcm, max_frames, &section);
+	}
+
+	auto push_marker = [this](bool eof) {
+		uint32_t mw = marker_write.load(std::memory_order_relaxed);
+		markers[mw % marker_count] = {ring.written(), decoder_rate, decoder_channels, eof};
+		marker_write.store(mw + 1, std::memory_order_release);
+	};
+
+	if(frames == 0)
+	{
+		// EOF twice in a row : nothing to play
+		if(last_eof)
 		{
-			if(source->mixer_channels == 1)
+			exhausted.store(true, std::memory_order_relaxed);
+			return false;
+		}
+		last_eof = true;
+		push_marker(true);
+		// auto loop (at the loop start if any) : the head follows at once, the decoder seeks after it
+		if(source->head_frames)
+		{
+			head_position = 0;
+			decoder_seek = source->head_start + source->head_frames;
+		}
+		else
+			ov_pcm_seek(&file, 0);
+		return true;
+	}
+	if(frames < 0)
+	{
+		// hole in the data
+		return true;
+	}
+
+	// multistream support : rate and channels can change
+	vorbis_info *vi = ov_info(&file, -1);
+	if(vi->rate != decoder_rate || vi->channels != decoder_channels)
+	{
+		decoder_rate = vi->rate;
+		decoder_channels = vi->channels;
+		push_marker(false);
+	}
+
+	// planar => interleaved, clipped as ov_read does
+	pending.resize(static_cast<size_t>(frames) * decoder_channels);
+	for(int c = 0; c < decoder_channels; ++c)
+	{
+		const float *in = pcm[c];
+		float *out = pending.data() + c;
+		for(long i = 0; i < frames; ++i, out += decoder_channels)
+			*out = std::clamp(in[i], -1.f, 1.f);
+	}
+	return flush();
+}
+
+long SampleVorbis::pull(char *data, int32_t max_size)
+{
+	for(;;)
+	{
+		uint64_t position = ring.consumed();
+		uint64_t limit = static_cast<uint64_t>(max_size);
+		uint32_t mr = marker_read.load(std::memory_order_relaxed);
+		if(mr != marker_write.load(std::memory_order_acquire))
+		{
+			const Marker &marker = markers[mr % marker_count];
+			if(marker.position == position)
 			{
-				// (channels) => mono
-				int32_t ina = 0, inb = 0;
-				char *b =  internal_buffer + buffer_idx;
-				for( int c = 0; c < channels; ++c)
-				{
-					ina += source->decoder(b);
-					inb += source->decoder(b + sample_size);
-					b += channel_size;
-				}
-				*out++ = static_cast<int32_t>((ina + alpha * (inb - ina)) / channels);
+				marker_read.store(mr + 1, std::memory_order_release);
+				if(marker.eof)
+					return 0;
+				configure(marker.rate, marker.channels);
+				continue;
 			}
-			else
+			limit = std::min(limit, marker.position - position);
+		}
+
+		size_t n = ring.read(data, static_cast<size_t>(limit - limit % sample_size));
+		if(n)
+			return static_cast<long>(n);
+		if(exhausted.load(std::memory_order_relaxed))
+			return 0;
+		// offline : the reader decodes
+		if(pooled || !decode_ahead())
+			return exhausted.load(std::memory_order_relaxed) ? 0 : -1;
+	}
+}
+
+template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+int32_t SampleVorbis::resample(int32_t *out, int32_t sample_count)
+{
+	// each output sample interpolates frames idx and idx + 1 : idx <= buffer_frames - 2
+	double available = (buffer_frames - 1 - sample_pos) / sample_step;
+	if(available <= 0.)
+		return 0;
+	sample_count = std::min(sample_count, static_cast<int32_t>(std::ceil(available)));
+	if(sample_count && static_cast<int32_t>(sample_pos + (sample_count - 1) * sample_step) > buffer_frames - 2)
+		--sample_count;
+
+	const float scale = source->scale;
+	const float *data = internal_buffer;
+	const int stride = channels;
+	int32_t idx;
+	double idx_d;
+	double alpha;
+
+	for(int32_t sample_number = 0; sample_number < sample_count; ++sample_number)
+	{
+		idx_d = sample_pos + sample_number * sample_step;
+		idx = static_cast<int32_t>(idx_d);
+		alpha = idx_d - idx;
+
+		const float *a = data + idx * stride;
+		const float *b = a + stride;
+
+		if constexpr (STEREO_INPUT && STEREO_OUTPUT)
+		{
+			// stereo -> stereo (first two channels)
+			*out++ = static_cast<int32_t>((a[0] + alpha * (b[0] - a[0])) * scale);
+			*out++ = static_cast<int32_t>((a[1] + alpha * (b[1] - a[1])) * scale);
+		}
+		else if constexpr (STEREO_OUTPUT)
+		{
+			// mono -> stereo
+			auto v = static_cast<int32_t>((a[0] + alpha * (b[0] - a[0])) * scale);
+			*out++ = v;
+			*out++ = v;
+		}
+		else if constexpr (STEREO_INPUT)
+		{
+			// (channels) -> mono
+			float ina = 0, inb = 0;
+			for(int c = 0; c < stride; ++c)
 			{
-				// we assume a stereo output : surround, 5.1, 7.1  - not supported (yet)
-				if(channels > 1)
-				{
-					// stereo => stereo
-					char *b =  internal_buffer + buffer_idx;
-
-					auto la = source->decoder(b);
-					auto ra = source->decoder(b + channel_size);
-					auto lb = source->decoder(b + sample_size);
-					auto rb = source->decoder(b + sample_size + channel_size);
-
-					*out++ = static_cast<int32_t>(la + alpha * (lb - la));
-					*out++ = static_cast<int32_t>(ra + alpha * (rb - ra));
-				}
-				else
-				{
-					// mono => stereo
-					auto ina = source->decoder(internal_buffer + buffer_idx );
-					auto inb = source->decoder(internal_buffer + buffer_idx + sample_size );
-					auto l = static_cast<int32_t>(ina + alpha * (inb - ina));
-					*out++ = l;
-					*out++=l;
-				}
+				ina += a[c];
+				inb += b[c];
 			}
-			++out_sample_count;
-			done = sample_count == out_sample_count;
-			sample_pos += sample_step;
+			*out++ = static_cast<int32_t>((ina + alpha * (inb - ina)) * scale / stride);
+		}
+		else
+		{
+			// mono -> mono
+			*out++ = static_cast<int32_t>((a[0] + alpha * (b[0] - a[0])) * scale);
 		}
 	}
+	sample_pos += sample_count * sample_step;
+	return sample_count;
+}
+
+int32_t SampleVorbis::read(int32_t *out, int32_t sample_count)
+{
+	MAJIMIX_PROFILE_SCOPE(vorbis_resample);
+	if(!opened)
+		return 0;
+	const int mixer_channels = source->mixer_channels;
+	int32_t out_sample_count = 0;
+
+	for(;;)
+	{
+		out_sample_count += resample_fn(out + out_sample_count * mixer_channels, sample_count - out_sample_count);
+		if(out_sample_count == sample_count)
+			break;
+
+		// refill : keep the frames from the current position (skip them if the position is beyond)
+		int32_t first = std::min(static_cast<int32_t>(sample_pos), buffer_frames);
+		int32_t kept = buffer_frames - first;
+		std::copy(internal_buffer + first * channels, internal_buffer + buffer_frames * channels, internal_buffer);
+		sample_pos -= first;
+		buffer_frames = kept;
+
+		int previous_channels = channels;
+		char *destination = reinterpret_cast<char *>(internal_buffer + kept * channels);
+		int32_t max_size = (internal_buffer_size - kept * channels) * static_cast<int32_t>(sizeof(float));
+		long read_val = pull(destination, max_size);
+		// gapless loop : the beginning follows the end in the ring, the last frames are interpolated with it
+		if(read_val == 0 && looping.load(std::memory_order_relaxed))
+			read_val = pull(destination, max_size);
+		if(read_val == 0)
+		{
+			// EOF - the decoder loops to the beginning
+			buffer_frames = 0;
+			sample_pos = 0;
+			break;
+		}
+		if(read_val < 0)
+		{
+			// underrun : the decoder is late, silence until the end of the block
+			std::fill(out + out_sample_count * mixer_channels, out + sample_count * mixer_channels, 0);
+			out_sample_count = sample_count;
+			break;
+		}
+		int32_t frames = static_cast<int32_t>(read_val / sample_size);
+		if(channels != previous_channels)
+		{
+			// new format (multistream) : the kept frames can not be interpolated with the new ones
+			std::copy(internal_buffer + kept * previous_channels, internal_buffer + kept * previous_channels + frames * channels, internal_buffer);
+			sample_pos -= static_cast<int32_t>(sample_pos);
+			kept = 0;
+		}
+		buffer_frames = kept + frames;
+	}
+	// mixing thread : the workers are woken after the block
+	if(pooled && ring.size() < ring.capacity() / 2)
+		StreamPool::instance().request();
 	return out_sample_count;
 }
 
+void SampleVorbis::seek_decoder(int64_t position)
+{
+	auto index = std::atomic_load(&source->seek_index);
+	if(!index || !index->seek(file, position))
+		ov_pcm_seek(&file, position);
+}
+
+void SampleVorbis::locate(int64_t position)
+{
+	if(position >= source->head_start && position < source->head_start + source->head_frames)
+	{
+		head_position = position - source->head_start;
+		decoder_seek = source->head_start + source->head_frames;
+	}
+	else
+	{
+		seek_decoder(position);
+		head_position = source->head_frames;
+		decoder_seek = -1;
+	}
+	restart();
+}
+
 void SampleVorbis::seek(long pos)
 {
-	max_buffer_idx = -1;
-	buffer_read_length = 0;
-	sample_pos = 0;
-	ov_pcm_seek(&file, pos);
+	if(!opened)
+		return;
+	std::lock_guard<std::mutex> lg(stream_mutex);
+	locate(pos);
 }
+
 void SampleVorbis::seek_time(double pos)
 {
-	max_buffer_idx = -1;
-	buffer_read_length = 0;
-	sample_pos = 0;
-	ov_time_seek(&file, pos);
+	if(!opened)
+		return;
+	std::lock_guard<std::mutex> lg(stream_mutex);
+	// the head and the index only exist for single bitstream files : one rate
+	if(source->head_frames || std::atomic_load(&source->seek_index))
+		locate(static_cast<int64_t>(pos * ov_info(&file, -1)->rate));
+	else
+	{
+		ov_time_seek(&file, pos);
+		head_position = source->head_frames;
+		decoder_seek = -1;
+		restart();
+	}
+}
+
+void SampleVorbis::set_loop(bool loop)
+{
+	looping.store(loop, std::memory_order_relaxed);
+}
+
+void SampleVorbis::rewind()
+{
+	if(!opened)
+		return;
+	{
+		std::lock_guard<std::mutex> lg(stream_mutex);
+		parked.store(true, std::memory_order_relaxed);
+		held.store(false, std::memory_order_relaxed);
+		// as a new sample : the head in memory then the decoder after it, or the decoder from 0
+		if(source->head_frames && !source->head_start)
+		{
+			head_position = 0;
+			decoder_seek = source->head_frames;
+		}
+		else
+		{
+			head_position = source->head_frames;
+			decoder_seek = 0;
+		}
+		restart(false);
+	}
+	if(pooled)
+		StreamPool::instance().notify();
+}
+
+void SampleVorbis::start(bool loop)
+{
+	looping.store(loop, std::memory_order_relaxed);
+	if(!opened)
+		return;
+	bool resume;
+	{
+		std::lock_guard<std::mutex> lg(stream_mutex);
+		resume = held.load(std::memory_order_relaxed);
+		parked.store(false, std::memory_order_relaxed);
+		held.store(false, std::memory_order_relaxed);
+		if(pooled && !ring.size())
+			for(int i = 0; i < 4 && decode_ahead(); ++i);
+	}
+	// held at the loop end : the workers go on
+	if(pooled && resume)
+		StreamPool::instance().notify();
 }
 
 double SampleVorbis::sample_time()
 {
+	if(!opened)
+		return 0;
+	std::lock_guard<std::mutex> lg(stream_mutex);
 	return ov_time_total(&file,-1);
 }
-}
\ No newline at end of file
+
+}
@@ -29,74 +29,249 @@
 #define SOURCE_VORBIS_HPP_
 
 #include "interfaces.hpp"
+#include "stream_pool.hpp"
+#include "asset_cache.hpp"
 #include <vorbis/vorbisfile.h>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 namespace majimix 
 {
+/* compressed Ogg bitstream in memory (SourceOptions::vorbis_in_memory, sound bank) and read position */
+struct OggMemory {
+    /* first byte - keeps the loaded file or the mapped bank alive */
+    std::shared_ptr<const char> data;
+    size_t size = 0;
+    size_t position = 0;
+};
+
+/* Ogg pages of a single logical bitstream file : granule position (end of page) => page offset */
+struct VorbisSeekIndex {
+    struct Entry {
+        int64_t granule;
+        int64_t offset;
+    };
+    std::vector<Entry> entries;
+
+    /* jump to the page before position and decode up to it - false : use ov_pcm_seek */
+    bool seek(OggVorbis_File &file, int64_t position) const;
+};
+
+class SampleVorbis;
+
 class SourceVorbis : public Source {
 
     std::string filename;
+    /* the compressed file if loaded in memory - shared by the samples */
+    std::shared_ptr<const char> data;
+    size_t data_size = 0;
+    /* data is in a mapped file (sound bank) */
+    bool data_mapped = false;
+    /* data loaded through the AssetCache (shared with the sources of the same file) */
+    bool shared = false;
 
-    /* sample decoder */
-    std::function<int32_t(const char *)> decoder;
-    int mixer_rate;
-    int mixer_bits; // 16/24
-    int mixer_channels;
+    /* seek index - published by index_thread (std::atomic_load / std::atomic_store) */
+    std::shared_ptr<const VorbisSeekIndex> seek_index;
+    std::thread index_thread;
+    std::atomic<bool> index_cancel {false};
+
+    /* LOOPSTART / LOOPLENGTH comments (frames) - loop_end = 0 : no loop points */
+    int64_t loop_start = 0;
+    int64_t loop_end = 0;
+
+    /* frames decoded from head_start (interleaved float) : the loops and the restarts are served from memory */
+    constexpr static int default_loop_head_ms = 250;
+    int loop_head_ms = 0;
+    std::vector<float> head;
+    int64_t head_start = 0;
+    int64_t head_frames = 0;
+
+    /* decoded float [-1, 1] to mixer sample */
+    float scale = 32767.f;
+    int mixer_rate = 0;
+    int mixer_bits = 16; // 16/24
+    int mixer_channels = 2;
+    /* samples decoded ahead by the StreamPool workers */
+    bool decode_ahead = false;
+
+    /* decoders opened in advance, ready to play (API thread) */
+    size_t decoder_pool_size = 0;
+    std::vector<std::unique_ptr<SampleVorbis>> decoders;
+    void fill_decoder_pool();
+    /* read the loop points and decode the head (at the loop start if any) */
+    void prepare_loop();
+    /* test the compressed file in memory and use it */
+    bool set_memory(const std::string &filename, std::shared_ptr<const char> bytes, size_t size);
 
     /* step of the Sample */
     friend class SampleVorbis;
 
 public:
-    bool set_file(const std::string &filename);
+    ~SourceVorbis();
+    /* in_memory : load the compressed file once, the samples decode from memory */
+    bool set_file(const std::string &filename, bool in_memory = false);
+    /* compressed file in a mapped sound bank : the samples decode from the mapping (name : for the logs) */
+    bool set_mapped(const std::string &name, std::shared_ptr<const char> bytes, size_t size);
+    /* true : the samples are decoded by the StreamPool, false : by the reader (offline rendering) */
+    void set_decode_ahead(bool enable);
+    /* the compressed file and the decoded PCM are shared (AssetCache) - call before set_file */
+    void set_shared(bool enable);
     /* set the mixer format */
     void set_output_format(int samples_per_sec, int channels = 2, int bits = 16) override;
-    /* create a SampleVorbis associated with this Source */
-    std::unique_ptr<Sample> create_sample() override;
+    /**
+     * Decode the whole file to 16 bits PCM if it is shorter than max_ms milliseconds or its
+     * PCM size is under max_bytes (0 : no limit of this kind). Returns false if the file is
+     * too long or if its sections have different formats.
+     */
+    bool decode_to_pcm(int max_ms, int max_bytes, AssetCache::Data &pcm, int &rate, int &channels) const;
+    /**
+     * Build the seek index in a background thread (set_file first). The samples seek with
+     * ov_pcm_seek until it is ready. persistent : the index is loaded from / saved to
+     * <file>.idx, it is rebuilt if the file size or date changed.
+     */
+    void build_seek_index(bool persistent);
+    /* milliseconds decoded in memory by set_file (single bitstream files) - call before set_file */
+    void set_loop_head(int ms);
+    bool get_loop_points(int64_t &start, int64_t &end) const override;
+    /* compressed file in memory and head */
+    size_t memory_size() const override;
+    /* number of decoders kept ready to play (opened when the output format is set) */
+    void set_decoder_pool_size(int count);
+    /* create a SampleVorbis associated with this Source - from the pool if any */
+    std::unique_ptr<Sample> create_sample(bool loop = false) override;
+    /* true while the pool is not full */
+    bool recycles_samples() const override;
+    /* back to the pool - rewound by the decoder (StreamPool worker with decode ahead) */
+    void recycle_sample(std::unique_ptr<Sample> sample) override;
 };
 
-class SampleVorbis : public Sample
+/**
+ * @class SampleVorbis
+ * @brief Vorbis sample : the decoded PCM (interleaved float) is buffered in a ring.
+ *
+ * With decode ahead, the ring is filled by the StreamPool workers and read() never
+ * touches the file nor the codec. Otherwise read() decodes when the ring is empty.
+ */
+class SampleVorbis : public Sample, public Stream
 {
     const SourceVorbis *source;
     std::ifstream stream;
+    OggMemory memory;
     OggVorbis_File file;
+    bool opened = false;
+    /* registered in the StreamPool */
+    bool pooled = false;
 
     /* sample rate : sample per sec */
     int sample_rate;
-    /* size of one sample : 1 sample <=> format size (octets) x channels  : ex 16 bits stereo => 2 x 2 = 4 */
+    /* size of one sample in the ring (octets) : float x channels */
     int sample_size;
     /* channels count */
     int channels;
-    /* size of one channel = sample_size / channels */
-    int channel_size;
 
     double sample_step;
 
-    /* multistream support */
-    int current_section, last_section;
-
-    int32_t min_buffer_data_size;
-    int32_t max_buffer_idx;
+    /* position (frames) in internal_buffer */
     double sample_pos;
 
     bool initialized = false;
 
-    constexpr static int internal_buffer_size = 4096;
-    char internal_buffer[internal_buffer_size];
-    int32_t buffer_read_length;
+    /* PCM pulled from the ring, resampled in blocks - size in floats */
+    constexpr static int internal_buffer_size = 8192;
+    alignas(32) float internal_buffer[internal_buffer_size];
+    /* frames in internal_buffer */
+    int32_t buffer_frames;
+
+    /** Function pointer typedef for the resampling kernel */
+    using Resampler = std::function<int32_t(int32_t *, int32_t)>;
+    /** kernel selected by configure */
+    Resampler resample_fn;
+
+    /* decoded PCM */
+    constexpr static size_t ring_size = 1 << 17;
+    constexpr static int decode_frames = 1024;
+    constexpr static size_t decode_size = decode_frames * 2 * sizeof(float);
+    ByteRing ring;
+    /* ov_read_float output interleaved, waiting for space in the ring (worker side) */
+    std::vector<float> pending;
+    size_t pending_offset = 0;
+
+    /* format change (multistream support) or end of stream at a ring position */
+    struct Marker {
+        uint64_t position;
+        int rate;
+        int channels;
+        bool eof;
+    };
+    constexpr static uint32_t marker_count = 16;
+    std::array<Marker, marker_count> markers;
+    std::atomic<uint32_t> marker_write {0};
+    std::atomic<uint32_t> marker_read {0};
+
+    /* decoder state (stream_mutex) */
+    int decoder_rate = 0;
+    int decoder_channels = 0;
+    bool last_eof = false;
+    std::atomic<bool> exhausted {false};
+    /* next frame of the source head to write in the ring, from head_start (head_frames : done) */
+    int64_t head_position = 0;
+    /* the decoder goes there before decoding (-1 : none) - done by the worker */
+    int64_t decoder_seek = -1;
+
+    /* played in a loop : read() goes on through the end of stream */
+    std::atomic<bool> looping {false};
+    /* decoder of the pool : the loop state is not known, the decoding stops at the loop end (held) until start() */
+    std::atomic<bool> parked {false};
+    std::atomic<bool> held {false};
 
     /* verifies and completes source initialization */
-    void configure();
+    void configure(int rate, int channels);
+    /* empty the ring and decode from the current position of the file (stream_mutex held)
+       prefill : the first blocks are decoded by the caller (decode ahead) */
+    void restart(bool prefill = true);
+    /* move the decoder : with the source index if it is ready, else ov_pcm_seek (stream_mutex held) */
+    void seek_decoder(int64_t position);
+    /* seek and restart : from the head in memory if position is in it (stream_mutex held) */
+    void locate(int64_t position);
+    /* get decoded bytes from the ring : 0 at the end of the stream, -1 if the ring is empty */
+    long pull(char *data, int32_t max_size);
+
+    /**
+     * @brief Resample from internal_buffer to the mixer output buffer
+     *
+     * @tparam STEREO_INPUT
+     * @tparam STEREO_OUTPUT
+     * @param out mixer output buffer
+     * @param sample_count maximum number of output samples
+     * @return number of output samples - less than sample_count when internal_buffer needs more data
+     */
+    template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+    int32_t resample(int32_t *out, int32_t sample_count);
 
 public:
-    SampleVorbis(const SourceVorbis &s);
+    /* loop : set before the first blocks are decoded - in_pool : decoder kept in the pool of the source (parked) */
+    SampleVorbis(const SourceVorbis &s, bool loop = false, bool in_pool = false);
     ~SampleVorbis();
     int32_t read(int32_t *buffer, int32_t sample_count) override;
     void seek(long pos) override;
     void seek_time(double pos) override;
+    void set_loop(bool loop) override;
     /* duration in seconds */
     double sample_time();
+    /* back to the beginning, parked in the pool : the decoder seek and the first blocks are left to the
+       StreamPool workers (to the reader without decode ahead) */
+    void rewind();
+    /* out of the pool : set the loop state (the decoding goes on past the loop end or at the loop start)
+       and decode the first blocks if the workers have not done it yet */
+    void start(bool loop);
+
+    float buffered() const override;
+    bool decode_ahead() override;
 };
 
 }
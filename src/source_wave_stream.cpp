@@ -0,0 +1,393 @@
+/**
+ * @file source_wave_stream.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "source_wave_stream.hpp"
+#include "source_pcm.hpp"
+#include "wave.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace majimix {
+
+/* ---------------------- SourceWaveStream ----------------------------- */
+
+bool SourceWaveStream::set_file(const std::string &filename)
+{
+	wave::pcm_data pcm_data;
+	if(!wave::load_wave(filename, pcm_data, false))
+		return false;
+	return set_file(filename, pcm_data);
+}
+
+bool SourceWaveStream::set_file(const std::string &filename, const wave::pcm_data &pcm_data)
+{
+	const wave::fmt_base &fmt = pcm_data.fmt;
+	format = wave_au_format(fmt);
+	// frames are converted to int32 x channels : up to 8 channels (7.1)
+	if(format == AuFormat::none || !fmt.nChannels || fmt.nChannels > 8 || !fmt.nSamplesPerSec || fmt.nBlockAlign < fmt.nChannels)
+		return false;
+
+	this->filename = filename;
+	sample_rate    = fmt.nSamplesPerSec;
+	sample_size    = fmt.nBlockAlign;
+	channels       = fmt.nChannels;
+	channel_size   = fmt.nBlockAlign / fmt.nChannels;
+	data_offset    = pcm_data.data_offset;
+	size           = pcm_data.sample_size;
+	loop_start     = 0;
+	loop_end       = 0;
+	if(pcm_data.loop_end && pcm_data.loop_start < pcm_data.loop_end && pcm_data.loop_end <= size)
+	{
+		loop_start = pcm_data.loop_start;
+		loop_end   = pcm_data.loop_end;
+	}
+	decoder = pcm_decoder(format, mixer_bits);
+	return size > 0;
+}
+
+void SourceWaveStream::set_decode_ahead(bool enable)
+{
+	decode_ahead = enable;
+}
+
+void SourceWaveStream::set_output_format(int samples_per_sec, int channels, int bits)
+{
+	mixer_rate = samples_per_sec;
+	mixer_channels = channels;
+	mixer_bits = bits;
+	decoder = pcm_decoder(format, mixer_bits);
+}
+
+bool SourceWaveStream::get_loop_points(int64_t &start, int64_t &end) const
+{
+	if(!loop_end)
+		return false;
+	start = loop_start;
+	end = loop_end;
+	return true;
+}
+
+std::unique_ptr<Sample> SourceWaveStream::create_sample(bool loop)
+{
+	if(!decoder || mixer_rate <= 0)
+		return nullptr;
+	return std::make_unique<SampleWaveStream>(*this, loop);
+}
+
+
+/* ---------------------- SampleWaveStream ----------------------------- */
+
+SampleWaveStream::SampleWaveStream(const SourceWaveStream &s, bool loop)
+: source {&s},
+  ring {ring_size},
+  frame_size {static_cast<int>(sizeof(int32_t)) * s.channels}
+{
+	// the loop end is known before the first blocks are read
+	looping.store(loop, std::memory_order_relaxed);
+	stream.open(source->filename, std::ios::binary);
+	if(!stream)
+		return;
+	opened = true;
+	file_buffer.resize(static_cast<size_t>(read_frames) * source->sample_size);
+	converted.resize(static_cast<size_t>(read_frames) * source->channels);
+
+	sample_step = static_cast<double>(source->sample_rate) / source->mixer_rate;
+
+	/* resampling kernel */
+	if(source->mixer_channels == 1)
+	{
+		if(source->channels > 1)
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<true, false>(out, count); };
+		else
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<false, false>(out, count); };
+	}
+	else
+	{
+		if(source->channels > 1)
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<true, true>(out, count); };
+		else
+			resample_fn = [this](int32_t *out, int32_t count) { return resample<false, true>(out, count); };
+	}
+
+	pooled = source->decode_ahead;
+	restart(0);
+	if(pooled)
+		StreamPool::instance().add(this);
+}
+
+SampleWaveStream::~SampleWaveStream()
+{
+	if(pooled)
+		StreamPool::instance().remove(this);
+}
+
+void SampleWaveStream::seek_file(uint64_t position)
+{
+	stream.clear();
+	stream.seekg(static_cast<std::streamoff>(source->data_offset + position * source->sample_size));
+	file_position = position;
+}
+
+void SampleWaveStream::restart(uint64_t position)
+{
+	ring.clear();
+	marker_read.store(0, std::memory_order_relaxed);
+	marker_write.store(0, std::memory_order_relaxed);
+	exhausted.store(false, std::memory_order_relaxed);
+	last_eof = false;
+	buffer_frames = 0;
+	sample_pos = 0;
+	seek_file(position);
+
+	// the first blocks are available before the workers get the stream
+	if(pooled)
+		for(int i = 0; i < 4 && decode_ahead(); ++i);
+}
+
+float SampleWaveStream::buffered() const
+{
+	if(exhausted.load(std::memory_order_relaxed) || ring.space() < static_cast<size_t>(read_frames * frame_size)
+	   || marker_write.load(std::memory_order_relaxed) - marker_read.load(std::memory_order_relaxed) >= marker_count)
+		return 1.f;
+	return static_cast<float>(ring.size()) / ring.capacity();
+}
+
+bool SampleWaveStream::decode_ahead()
+{
+	if(!opened || buffered() >= 1.f)
+		return false;
+
+	// looping : the loop end is followed by the loop start (once the loop end is reached)
+	bool loop = looping.load(std::memory_order_relaxed);
+	uint64_t end = source->size;
+	if(loop && source->loop_end && file_position <= static_cast<uint64_t>(source->loop_end))
+		end = static_cast<uint64_t>(source->loop_end);
+
+	size_t frames = 0;
+	if(file_position < end)
+	{
+		MAJIMIX_PROFILE_SCOPE(wave_read);
+		auto count = static_cast<size_t>(std::min<uint64_t>(read_frames, end - file_position));
+		stream.read(file_buffer.data(), static_cast<std::streamsize>(count * source->sample_size));
+		frames = static_cast<size_t>(stream.gcount()) / source->sample_size;
+
+		// to the mixer format
+		const char *in = file_buffer.data();
+		int32_t *out = converted.data();
+		const size_t values = frames * source->channels;
+		for(size_t i = 0; i < values; ++i, in += source->channel_size)
+			*out++ = source->decoder(in);
+	}
+
+	if(!frames)
+	{
+		// end of the data (or truncated file) twice in a row : nothing to play
+		if(last_eof)
+		{
+			exhausted.store(true, std::memory_order_relaxed);
+			return false;
+		}
+		last_eof = true;
+		if(loop)
+		{
+			// continuous : no end of stream in the ring
+			seek_file(end == static_cast<uint64_t>(source->loop_end) ? source->loop_start : 0);
+			return true;
+		}
+		uint32_t mw = marker_write.load(std::memory_order_relaxed);
+		markers[mw % marker_count] = ring.written();
+		marker_write.store(mw + 1, std::memory_order_release);
+		// auto loop : the next pass is read ahead
+		seek_file(0);
+		return true;
+	}
+
+	last_eof = false;
+	file_position += frames;
+	ring.write(reinterpret_cast<const char *>(converted.data()), frames * frame_size);
+	return true;
+}
+
+long SampleWaveStream::pull(char *data, int32_t max_size)
+{
+	for(;;)
+	{
+		uint64_t position = ring.consumed();
+		uint64_t limit = static_cast<uint64_t>(max_size);
+		uint32_t mr = marker_read.load(std::memory_order_relaxed);
+		if(mr != marker_write.load(std::memory_order_acquire))
+		{
+			uint64_t marker = markers[mr % marker_count];
+			if(marker == position)
+			{
+				marker_read.store(mr + 1, std::memory_order_release);
+				return 0;
+			}
+			limit = std::min(limit, marker - position);
+		}
+
+		size_t n = ring.read(data, static_cast<size_t>(limit - limit % frame_size));
+		if(n)
+			return static_cast<long>(n);
+		if(exhausted.load(std::memory_order_relaxed))
+			return 0;
+		// offline : the reader reads the file
+		if(pooled || !decode_ahead())
+			return exhausted.load(std::memory_order_relaxed) ? 0 : -1;
+	}
+}
+
+template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+int32_t SampleWaveStream::resample(int32_t *out, int32_t sample_count)
+{
+	// each output sample interpolates frames idx and idx + 1 : idx <= buffer_frames - 2
+	double available = (buffer_frames - 1 - sample_pos) / sample_step;
+	if(available <= 0.)
+		return 0;
+	sample_count = std::min(sample_count, static_cast<int32_t>(std::ceil(available)));
+	if(sample_count && static_cast<int32_t>(sample_pos + (sample_count - 1) * sample_step) > buffer_frames - 2)
+		--sample_count;
+
+	const int32_t *data = internal_buffer;
+	const int stride = source->channels;
+	int32_t idx;
+	double idx_d;
+	double alpha;
+
+	// same arithmetic as SourcePCMF
+	for(int32_t sample_number = 0; sample_number < sample_count; ++sample_number)
+	{
+		idx_d = sample_pos + sample_number * sample_step;
+		idx = static_cast<int32_t>(idx_d);
+		alpha = idx_d - idx;
+
+		const int32_t *a = data + idx * stride;
+		const int32_t *b = a + stride;
+
+		if constexpr (STEREO_INPUT && STEREO_OUTPUT)
+		{
+			// stereo -> stereo (first two channels)
+			int32_t cl = a[0] + alpha * (b[0] - a[0]);
+			int32_t cr = a[1] + alpha * (b[1] - a[1]);
+			*out++ = cl;
+			*out++ = cr;
+		}
+		else if constexpr (STEREO_OUTPUT)
+		{
+			// mono -> stereo
+			int32_t v = a[0] + alpha * (b[0] - a[0]);
+			*out++ = v;
+			*out++ = v;
+		}
+		else if constexpr (STEREO_INPUT)
+		{
+			// stereo -> mono
+			int32_t v = (a[0] + a[1] + alpha * (b[0] - a[0] + b[1] - a[1])) * 0.5;
+			*out++ = v;
+		}
+		else
+		{
+			// mono -> mono
+			int32_t v = a[0] + alpha * (b[0] - a[0]);
+			*out++ = v;
+		}
+	}
+	sample_pos += sample_count * sample_step;
+	return sample_count;
+}
+
+int32_t SampleWaveStream::read(int32_t *out, int32_t sample_count)
+{
+	MAJIMIX_PROFILE_SCOPE(wave_resample);
+	if(!opened)
+		return 0;
+	const int mixer_channels = source->mixer_channels;
+	const int channels = source->channels;
+	int32_t out_sample_count = 0;
+
+	for(;;)
+	{
+		out_sample_count += resample_fn(out + out_sample_count * mixer_channels, sample_count - out_sample_count);
+		if(out_sample_count == sample_count)
+			break;
+
+		// refill : keep the frames from the current position (skip them if the position is beyond)
+		int32_t first = std::min(static_cast<int32_t>(sample_pos), buffer_frames);
+		int32_t kept = buffer_frames - first;
+		std::copy(internal_buffer + first * channels, internal_buffer + buffer_frames * channels, internal_buffer);
+		sample_pos -= first;
+		buffer_frames = kept;
+
+		char *destination = reinterpret_cast<char *>(internal_buffer + kept * channels);
+		int32_t max_size = (internal_buffer_size - kept * channels) * static_cast<int32_t>(sizeof(int32_t));
+		long read_val = pull(destination, max_size);
+		// gapless loop : the beginning follows the end in the ring
+		if(read_val == 0 && looping.load(std::memory_order_relaxed))
+			read_val = pull(destination, max_size);
+		if(read_val == 0)
+		{
+			// EOF - the reader loops to the beginning
+			buffer_frames = 0;
+			sample_pos = 0;
+			break;
+		}
+		if(read_val < 0)
+		{
+			// underrun : the reader is late, silence until the end of the block
+			std::fill(out + out_sample_count * mixer_channels, out + sample_count * mixer_channels, 0);
+			out_sample_count = sample_count;
+			break;
+		}
+		buffer_frames = kept + static_cast<int32_t>(read_val / frame_size);
+	}
+	// mixing thread : the workers are woken after the block
+	if(pooled && ring.size() < ring.capacity() / 2)
+		StreamPool::instance().request();
+	return out_sample_count;
+}
+
+void SampleWaveStream::seek(long pos)
+{
+	if(!opened || pos < 0 || static_cast<uint64_t>(pos) >= source->size)
+		return;
+	std::lock_guard<std::mutex> lg(stream_mutex);
+	restart(static_cast<uint64_t>(pos));
+}
+
+void SampleWaveStream::seek_time(double pos)
+{
+	if(pos >= 0)
+		seek(static_cast<long>(pos * source->sample_rate));
+}
+
+void SampleWaveStream::set_loop(bool loop)
+{
+	looping.store(loop, std::memory_order_relaxed);
+}
+
+}
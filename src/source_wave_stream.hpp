@@ -0,0 +1,178 @@
+/**
+ * @file source_wave_stream.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef SOURCE_WAVE_STREAM_HPP_
+#define SOURCE_WAVE_STREAM_HPP_
+
+#include "interfaces.hpp"
+#include "stream_pool.hpp"
+#include <array>
+#include <atomic>
+#include <functional>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace majimix 
+{
+
+namespace wave { struct pcm_data; }
+
+/**
+ * @class SourceWaveStream
+ * @brief WAVE file played from the disk : only the headers are loaded.
+ *
+ * For the files too long to be kept in memory (RIFF, RF64 and Wave64 - no size limit).
+ */
+class SourceWaveStream : public Source
+{
+    std::string filename;
+
+    /* sample format */
+    AuFormat format = AuFormat::none;
+    int sample_rate = 0;
+    /* size of one frame in the file (octets) */
+    int sample_size = 0;
+    int channels = 0;
+    int channel_size = 0;
+    /* data chunk position in the file */
+    uint64_t data_offset = 0;
+    /* number of frames */
+    uint64_t size = 0;
+    /* smpl chunk (frames) - loop_end = 0 : no loop points */
+    int64_t loop_start = 0;
+    int64_t loop_end = 0;
+
+    /* sample decoder (one channel) */
+    std::function<int32_t(const char *)> decoder;
+
+    int mixer_rate = 0;
+    int mixer_bits = 16; // 16/24
+    int mixer_channels = 2;
+    /* samples read ahead by the StreamPool workers */
+    bool decode_ahead = false;
+
+    friend class SampleWaveStream;
+
+public:
+    /* read the headers */
+    bool set_file(const std::string &filename);
+    /* headers already read (wave::load_wave) */
+    bool set_file(const std::string &filename, const wave::pcm_data &pcm_data);
+    /* true : the samples are read by the StreamPool, false : by the reader (offline rendering) */
+    void set_decode_ahead(bool enable);
+    /* set the mixer format */
+    void set_output_format(int samples_per_sec, int channels = 2, int bits = 16) override;
+    bool get_loop_points(int64_t &start, int64_t &end) const override;
+    /* create a SampleWaveStream associated with this Source */
+    std::unique_ptr<Sample> create_sample(bool loop = false) override;
+};
+
+/**
+ * @class SampleWaveStream
+ * @brief Streamed WAVE sample : the frames, converted to the mixer format, are read ahead in a ring.
+ *
+ * With decode ahead, the ring is filled by the StreamPool workers and read() never
+ * touches the file. Otherwise read() reads the file when the ring is empty.
+ * The memory used does not depend on the file size.
+ */
+class SampleWaveStream : public Sample, public Stream
+{
+    const SourceWaveStream *source;
+    std::ifstream stream;
+    bool opened = false;
+    /* registered in the StreamPool */
+    bool pooled = false;
+
+    double sample_step = 0;
+    /* position (frames) in internal_buffer */
+    double sample_pos = 0;
+
+    /* frames pulled from the ring, resampled in blocks - size in int32 */
+    constexpr static int internal_buffer_size = 8192;
+    int32_t internal_buffer[internal_buffer_size];
+    /* frames in internal_buffer */
+    int32_t buffer_frames = 0;
+
+    /** Function pointer typedef for the resampling kernel */
+    using Resampler = std::function<int32_t(int32_t *, int32_t)>;
+    Resampler resample_fn;
+
+    /* converted frames (int32 x channels) */
+    constexpr static size_t ring_size = 1 << 18;
+    constexpr static int read_frames = 1024;
+    ByteRing ring;
+    /* size of one frame in the ring (octets) */
+    int frame_size;
+    /* file data and converted frames (worker side) */
+    std::vector<char> file_buffer;
+    std::vector<int32_t> converted;
+
+    /* end of the file at a ring position */
+    constexpr static uint32_t marker_count = 16;
+    std::array<uint64_t, marker_count> markers;
+    std::atomic<uint32_t> marker_write {0};
+    std::atomic<uint32_t> marker_read {0};
+
+    /* reader state (stream_mutex) */
+    uint64_t file_position = 0;
+    bool last_eof = false;
+    std::atomic<bool> exhausted {false};
+
+    /* played in a loop : the reader goes on at the loop start (or the beginning) at the end */
+    std::atomic<bool> looping {false};
+
+    /* move the reader in the data chunk (stream_mutex held) */
+    void seek_file(uint64_t position);
+    /* empty the ring and read from position (stream_mutex held) */
+    void restart(uint64_t position);
+    /* get frames from the ring : 0 at the end of the file, -1 if the ring is empty */
+    long pull(char *data, int32_t max_size);
+
+    /**
+     * @brief Resample from internal_buffer to the mixer output buffer
+     * @return number of output samples - less than sample_count when internal_buffer needs more data
+     */
+    template <bool STEREO_INPUT, bool STEREO_OUTPUT>
+    int32_t resample(int32_t *out, int32_t sample_count);
+
+public:
+    /* loop : set before the first blocks are read */
+    SampleWaveStream(const SourceWaveStream &s, bool loop = false);
+    ~SampleWaveStream();
+    int32_t read(int32_t *buffer, int32_t sample_count) override;
+    void seek(long pos) override;
+    void seek_time(double pos) override;
+    void set_loop(bool loop) override;
+
+    float buffered() const override;
+    bool decode_ahead() override;
+};
+
+}
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * @file stream_pool.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "stream_pool.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace majimix {
+
+/* ---------------------- ByteRing ----------------------------- */
+
+static size_t next_power_of_2(size_t n)
+{
+	size_t p = 1;
+	while(p < n)
+		p <<= 1;
+	return p;
+}
+
+ByteRing::ByteRing(size_t capacity)
+: buffer(next_power_of_2(std::max<size_t>(capacity, 2))),
+  mask {buffer.size() - 1},
+  write_pos {0},
+  read_pos {0}
+{}
+
+size_t ByteRing::size() const
+{
+	return static_cast<size_t>(write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_acquire));
+}
+
+size_t ByteRing::space() const
+{
+	return buffer.size() - size();
+}
+
+size_t ByteRing::write(const char *data, size_t n)
+{
+	uint64_t w = write_pos.load(std::memory_order_relaxed);
+	uint64_t r = read_pos.load(std::memory_order_acquire);
+	n = std::min(n, buffer.size() - static_cast<size_t>(w - r));
+	size_t idx = static_cast<size_t>(w) & mask;
+	size_t first = std::min(n, buffer.size() - idx);
+	std::memcpy(buffer.data() + idx, data, first);
+	std::memcpy(buffer.data(), data + first, n - first);
+	write_pos.store(w + n, std::memory_order_release);
+	return n;
+}
+
+size_t ByteRing::read(char *data, size_t n)
+{
+	uint64_t r = read_pos.load(std::memory_order_relaxed);
+	uint64_t w = write_pos.load(std::memory_order_acquire);
+	n = std::min(n, static_cast<size_t>(w - r));
+	size_t idx = static_cast<size_t>(r) & mask;
+	size_t first = std::min(n, buffer.size() - idx);
+	std::memcpy(data, buffer.data() + idx, first);
+	std::memcpy(data + first, buffer.data(), n - first);
+	read_pos.store(r + n, std::memory_order_release);
+	return n;
+}
+
+void ByteRing::clear()
+{
+	write_pos.store(0, std::memory_order_relaxed);
+	read_pos.store(0, std::memory_order_relaxed);
+}
+
+
+/* ---------------------- StreamPool ----------------------------- */
+
+StreamPool &StreamPool::instance()
+{
+	static StreamPool pool;
+	return pool;
+}
+
+StreamPool::~StreamPool()
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		running = false;
+	}
+	cv.notify_all();
+	for(auto &w : workers)
+		w.join();
+}
+
+void StreamPool::add(Stream *stream)
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		streams.push_back(stream);
+		if(!running)
+		{
+			running = true;
+			unsigned int count = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+			for(unsigned int i = 0; i < count; ++i)
+				workers.emplace_back(&StreamPool::run, this);
+		}
+	}
+	notify();
+}
+
+void StreamPool::remove(Stream *stream)
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		streams.erase(std::remove(streams.begin(), streams.end(), stream), streams.end());
+	}
+	// wait for the worker decoding this stream (if any)
+	std::lock_guard<std::mutex> lg(stream->stream_mutex);
+}
+
+void StreamPool::notify()
+{
+	// set under the mutex : a worker can not miss it between its check and its wait
+	{
+		std::lock_guard<std::mutex> lg(mutex);
+		pending = true;
+	}
+	cv.notify_one();
+}
+
+void StreamPool::request()
+{
+	requested.store(true, std::memory_order_release);
+}
+
+void StreamPool::notify_requested()
+{
+	if(requested.load(std::memory_order_relaxed) && requested.exchange(false, std::memory_order_acq_rel))
+		notify();
+}
+
+void StreamPool::run()
+{
+	MAJIMIX_PROFILE_THREAD("decoder");
+	std::unique_lock<std::mutex> lock(mutex);
+	while(running)
+	{
+		// least buffered stream first
+		Stream *selected = nullptr;
+		float selected_level = 1.f;
+		for(auto stream : streams)
+		{
+			float level = stream->buffered();
+			if(level < selected_level && stream->stream_mutex.try_lock())
+			{
+				if(selected)
+					selected->stream_mutex.unlock();
+				selected = stream;
+				selected_level = level;
+			}
+		}
+
+		bool decoded = false;
+		if(selected)
+		{
+			lock.unlock();
+			decoded = selected->decode_ahead();
+			selected->stream_mutex.unlock();
+			lock.lock();
+		}
+
+		// nothing to do : sleep until notified (pending is checked and reset under the mutex)
+		if(!decoded)
+		{
+			cv.wait(lock, [this] { return pending || !running; });
+			pending = false;
+		}
+	}
+}
+
+}
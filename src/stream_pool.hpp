@@ -0,0 +1,151 @@
+/**
+ * @file stream_pool.hpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef STREAM_POOL_HPP_
+#define STREAM_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace majimix {
+
+/**
+ * @class ByteRing
+ * @brief Single producer / single consumer ring of bytes (lock free).
+ */
+class ByteRing
+{
+	std::vector<char> buffer;
+	size_t mask;
+	/** total number of bytes written (producer) */
+	std::atomic<uint64_t> write_pos;
+	/** total number of bytes read (consumer) */
+	std::atomic<uint64_t> read_pos;
+
+public:
+	/** @param capacity rounded up to a power of 2 */
+	explicit ByteRing(size_t capacity);
+
+	size_t capacity() const { return buffer.size(); }
+	/** readable bytes */
+	size_t size() const;
+	/** writable bytes */
+	size_t space() const;
+
+	/* producer */
+	size_t write(const char *data, size_t n);
+	uint64_t written() const { return write_pos.load(std::memory_order_acquire); }
+
+	/* consumer */
+	size_t read(char *data, size_t n);
+	uint64_t consumed() const { return read_pos.load(std::memory_order_acquire); }
+
+	/** empty the ring - no concurrent access allowed */
+	void clear();
+};
+
+
+/**
+ * @class Stream
+ * @brief A source decoded ahead of the mixer by the StreamPool workers.
+ */
+class Stream
+{
+	friend class StreamPool;
+
+protected:
+	/** held by a worker while decoding : lock it to access the decoder from another thread */
+	std::mutex stream_mutex;
+
+public:
+	virtual ~Stream() = default;
+
+	/** buffered ratio [0, 1] : the workers serve the least buffered stream first */
+	virtual float buffered() const = 0;
+
+	/**
+	 * @brief Decode one chunk ahead (worker thread, stream_mutex held)
+	 * @return false if there is nothing to decode (buffer full or end of stream)
+	 */
+	virtual bool decode_ahead() = 0;
+};
+
+
+/**
+ * @class StreamPool
+ * @brief Shared pool of decoding threads.
+ *
+ * The mixing thread only reads decoded data from the streams rings, the workers do
+ * the file I/O and the decoding. The threads are started with the first stream.
+ */
+class StreamPool
+{
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::vector<Stream *> streams;
+	std::vector<std::thread> workers;
+	bool running = false;
+	/** work to do (mutex) : the idle workers wait for it */
+	bool pending = false;
+	/** wake requested by the mixing thread (request) */
+	std::atomic<bool> requested {false};
+
+	StreamPool() = default;
+	void run();
+
+public:
+	~StreamPool();
+	StreamPool(const StreamPool &) = delete;
+	StreamPool &operator=(const StreamPool &) = delete;
+
+	static StreamPool &instance();
+
+	void add(Stream *stream);
+
+	/** remove a stream - returns when no worker uses it */
+	void remove(Stream *stream);
+
+	/** wake a worker - locks the pool mutex : not from the mixing thread (request) */
+	void notify();
+
+	/**
+	 * @brief Ask for a wake from the mixing thread - lock free, no system call.
+	 *        The workers are woken by notify_requested, once the block is mixed.
+	 */
+	void request();
+
+	/** notify if a wake was requested - called after each mixing block (outside the real-time section) */
+	void notify_requested();
+};
+
+}
+
+#endif
@@ -0,0 +1,563 @@
+/**
+ * @file stress.cpp
+ * @author  agent
+ * @date 2026-10-17
+ *
+ * @section stress_desc DESCRIPTION
+ *
+ * majimix_stress : voice capacity of the mixer.
+ *
+ * For each kind of voice (WAVE at various rates and channel counts, Vorbis, KSS lines)
+ * the number of concurrent voices is increased until a mixing block takes longer
+ * than its real-time budget (block size / sampling rate).
+ * The mix is rendered headless (MajimixOffline) on the calling thread.
+ *
+ * Reported values :
+ *   - the maximum sustainable voice count
+ *   - the real-time factor of a block at this count (block time / budget)
+ *   - the cost of one voice (µs per block and % of the budget)
+ *
+ * With --rt-check (majimix built with MAJIMIX_RT_CHECK) the tool plays every kind of source
+ * (each WAVE format, QOA, a generated KSS file, a sound bank and the Vorbis file given with --ogg)
+ * with each storage mode of SourceOptions (in memory, native, mapped, streamed, ...) and counts
+ * the allocations and blocking calls made by the mixing code instead. The exit code is 1 if a
+ * violation is found (this is the rt_check test of CTest).
+ *
+ * With --native-check the tool checks the WAVE sources converted to the mixer sample type
+ * (SourceOptions::pcm_native) : after a change of the mixer format (16 then 24 bits) they must
+ * play as the sources added to a 24 bits mixer. The exit code is 1 if the output differs.
+ *
+ * usage : majimix_stress [--rate n] [--bits 16|24] [--mono] [--block n] [--measure n] [--percentile p]
+ *                        [--max n] [--ogg file] [--kss file [--track n]] [--rt-check] [--native-check]
+ *
+ * @section majimix_lic LICENSE
+ *
+ * The MIT License (MIT)
+ *
+ * @copyright Copyright © 2026 - agent
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the “Software”), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "bench_common.hpp"
+#include "majimix_core.hpp"
+#include "rt_check.hpp"
+#include "sound_bank.hpp"
+#include "source_pcm.hpp"
+#include "wave.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <tuple>
+
+using namespace majimix;
+
+namespace {
+
+struct Options {
+	int rate = 44100;
+	int bits = 16;
+	bool stereo = true;
+	int block = 512;          // frames per mixing block
+	int warmup = 8;           // blocks rendered before measuring
+	int measure = 64;         // blocks measured for each voice count
+	double percentile = 99.;  // block time retained
+	int max = 4095;           // voice count limit (handle limit)
+	std::string ogg;
+	std::string kss;
+	int track = 1;
+	bool rt_check = false;
+	bool native_check = false;
+};
+
+Options options;
+volatile int64_t sink;
+
+/**
+ * A kind of voice : prepares a mixer playing n voices
+ */
+struct VoiceKind {
+	std::string name;
+	std::function<bool(MajimixOffline &mixer, int n)> setup;
+};
+
+/** block time (ns) at the requested percentile */
+double block_time(const VoiceKind &kind, int n)
+{
+	MajimixOffline mixer;
+	if(!mixer.set_format(options.rate, options.stereo, options.bits, std::max(1, n))
+	   || !mixer.set_mixer_buffer_parameters(2, options.block)
+	   || !kind.setup(mixer, n))
+		return -1;
+
+	std::vector<char> out;
+	for(int i = 0; i < options.warmup; ++i)
+		mixer.render(out);
+
+	std::vector<double> times(options.measure);
+	for(auto &t : times)
+	{
+		bench::Stopwatch sw;
+		mixer.render(out);
+		t = sw.elapsed_ns();
+		sink = sink + out[0];
+	}
+	std::sort(times.begin(), times.end());
+	size_t idx = static_cast<size_t>(options.percentile / 100. * (times.size() - 1) + .5);
+	return times[std::min(idx, times.size() - 1)];
+}
+
+void stress(const VoiceKind &kind)
+{
+	const double budget_ns = 1e9 * options.block / options.rate;
+
+	double base_ns = block_time(kind, 0);
+	if(base_ns < 0)
+	{
+		std::cerr << kind.name << " : setup failed\n";
+		return;
+	}
+
+	// exponential ramp then bisection : last sustainable count in [low, high[
+	int low = 0;
+	double low_ns = base_ns;
+	int high = 0;
+	for(int n = 1; ; n = std::min(n * 2, options.max))
+	{
+		double ns = block_time(kind, n);
+		if(ns < 0)
+		{
+			std::cerr << kind.name << " : setup failed for " << n << " voices\n";
+			return;
+		}
+		if(ns > budget_ns)
+		{
+			high = n;
+			break;
+		}
+		low = n;
+		low_ns = ns;
+		if(n == options.max)
+			break;
+	}
+	while(high && high - low > 1)
+	{
+		int mid = (low + high) / 2;
+		double ns = block_time(kind, mid);
+		if(ns > budget_ns)
+			high = mid;
+		else
+		{
+			low = mid;
+			low_ns = ns;
+		}
+	}
+
+	double voice_ns = low ? (low_ns - base_ns) / low : 0;
+	std::printf("%-24s %8d%s %8.3f %12.3f %10.3f\n", kind.name.c_str(), low, high ? " " : "+",
+	            low_ns / budget_ns, voice_ns / 1000., 100. * voice_ns / budget_ns);
+}
+
+/** n looping voices of the given sources (played in turn) */
+VoiceKind sources_kind(const std::string &name, std::vector<std::string> files, SourceOptions source_options = {})
+{
+	return {name, [files, source_options](MajimixOffline &mixer, int n) {
+		std::vector<int> handles;
+		for(auto &f : files)
+		{
+			int h = mixer.add_source(f, source_options);
+			if(!h)
+				return false;
+			handles.push_back(h);
+		}
+		for(int i = 0; i < n; ++i)
+			if(!mixer.play_source(handles[i % handles.size()], true))
+				return false;
+		return true;
+	}};
+}
+
+/** n looping voices of the assets of a sound bank (played in turn) */
+VoiceKind bank_kind(const std::string &name, const std::string &bank_file, SourceOptions source_options = {})
+{
+	return {name, [bank_file, source_options](MajimixOffline &mixer, int n) {
+		std::vector<int> handles;
+		for(auto &[asset, h] : mixer.add_bank(bank_file, source_options))
+			handles.push_back(h);
+		if(handles.empty())
+			return false;
+		for(int i = 0; i < n; ++i)
+			if(!mixer.play_source(handles[i % handles.size()], true))
+				return false;
+		return true;
+	}};
+}
+
+/**
+ * Write a sound bank of WAVE files (PCM assets, looping on their second half) and of a Vorbis file
+ */
+bool write_bank(const std::string &bank_file, const std::vector<std::string> &waves, const std::string &ogg)
+{
+	std::vector<SoundBank::Asset> assets;
+	for(auto &file : waves)
+	{
+		wave::pcm_data pcm;
+		if(!wave::load_wave(file, pcm))
+			return false;
+		SoundBank::Asset asset;
+		asset.name         = std::filesystem::path(file).filename().string();
+		asset.kind         = bank::Kind::pcm;
+		asset.format       = static_cast<uint32_t>(wave_au_format(pcm.fmt));
+		asset.rate         = pcm.fmt.nSamplesPerSec;
+		asset.channels     = pcm.fmt.nChannels;
+		asset.channel_size = static_cast<uint16_t>(pcm.fmt.nBlockAlign / pcm.fmt.nChannels);
+		asset.loop_end     = static_cast<uint32_t>(pcm.data.size() / pcm.fmt.nBlockAlign);
+		asset.loop_start   = asset.loop_end / 2;
+		asset.data         = std::move(pcm.data);
+		assets.push_back(std::move(asset));
+	}
+	if(!ogg.empty())
+	{
+		std::ifstream in(ogg, std::ios::binary);
+		SoundBank::Asset asset;
+		asset.name = std::filesystem::path(ogg).filename().string();
+		asset.kind = bank::Kind::vorbis;
+		asset.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		if(asset.data.empty())
+			return false;
+		assets.push_back(std::move(asset));
+	}
+	return SoundBank::write(bank_file, std::move(assets));
+}
+
+/**
+ * Real-time safety check : n voices of each kind, returns the number of kinds with violations
+ */
+int check_real_time(const std::vector<VoiceKind> &kinds, int n)
+{
+	int failed = 0;
+	std::printf("%-24s %10s\n", "voice", "violations");
+	for(auto &kind : kinds)
+	{
+		MajimixOffline mixer;
+		// the Vorbis sources are decoded by the worker pool, as with an audio backend
+		mixer.set_decode_ahead(true);
+		if(!mixer.set_format(options.rate, options.stereo, options.bits, n)
+		   || !mixer.set_mixer_buffer_parameters(2, options.block)
+		   || !kind.setup(mixer, n))
+		{
+			std::cerr << kind.name << " : setup failed\n";
+			++failed;
+			continue;
+		}
+		std::vector<char> out;
+		mixer.render(out); // out allocation
+
+		rt_check::reset();
+		for(int i = 0; i < options.measure; ++i)
+			mixer.render(out);
+		uint64_t count = rt_check::violation_count();
+		std::printf("%-24s %10llu\n", kind.name.c_str(), static_cast<unsigned long long>(count));
+		if(count)
+			++failed;
+	}
+	return failed;
+}
+
+/**
+ * Native conversion check : the file played by a mixer set to 16 bits then 24 bits after
+ * add_source and by a mixer set to 24 bits before - returns true if the outputs are the same
+ */
+bool check_native(const std::string &filename)
+{
+	SourceOptions native;
+	native.pcm_native = true;
+
+	auto render_24 = [&](bool set_16_first, std::vector<char> &all) {
+		MajimixOffline mixer;
+		if(!mixer.set_format(options.rate, options.stereo, set_16_first ? 16 : 24, 1)
+		   || !mixer.set_mixer_buffer_parameters(2, options.block))
+			return false;
+		int h = mixer.add_source(filename, native);
+		if(!h || (set_16_first && !mixer.set_format(options.rate, options.stereo, 24, 1))
+		   || !mixer.play_source(h, false))
+			return false;
+		std::vector<char> out;
+		for(int i = 0; i < options.measure; ++i)
+		{
+			mixer.render(out);
+			all.insert(all.end(), out.begin(), out.end());
+		}
+		return true;
+	};
+
+	std::vector<char> expected;
+	std::vector<char> actual;
+	return render_24(false, expected) && render_24(true, actual) && expected == actual;
+}
+
+void usage()
+{
+	std::cout << "usage : majimix_stress [--rate n] [--bits 16|24] [--mono] [--block n] [--measure n] [--percentile p]\n"
+	             "                       [--max n] [--ogg file] [--kss file [--track n]] [--rt-check] [--native-check]\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if(arg == "--rate" && has_value)
+			options.rate = std::atoi(argv[++i]);
+		else if(arg == "--bits" && has_value)
+			options.bits = std::atoi(argv[++i]);
+		else if(arg == "--mono")
+			options.stereo = false;
+		else if(arg == "--block" && has_value)
+			options.block = std::max(16, std::atoi(argv[++i]));
+		else if(arg == "--measure" && has_value)
+			options.measure = std::max(1, std::atoi(argv[++i]));
+		else if(arg == "--percentile" && has_value)
+			options.percentile = std::clamp(std::atof(argv[++i]), 0., 100.);
+		else if(arg == "--max" && has_value)
+			options.max = std::clamp(std::atoi(argv[++i]), 1, 4095);
+		else if(arg == "--ogg" && has_value)
+			options.ogg = argv[++i];
+		else if(arg == "--kss" && has_value)
+			options.kss = argv[++i];
+		else if(arg == "--track" && has_value)
+			options.track = std::atoi(argv[++i]);
+		else if(arg == "--rt-check")
+			options.rt_check = true;
+		else if(arg == "--native-check")
+			options.native_check = true;
+		else
+		{
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+	}
+
+	{
+		MajimixOffline check;
+		if(!check.set_format(options.rate, options.stereo, options.bits, 1))
+		{
+			std::cerr << "invalid format\n";
+			return 1;
+		}
+	}
+
+	// WAVE assets : 2 seconds, s16, various rates and channel counts
+	const std::string dir = bench::temp_directory("majimix_stress");
+
+	if(options.native_check)
+	{
+		// the formats converted for a 16 bits mixer (and played from the file data at 24 bits)
+		int failed = 0;
+		const std::tuple<const char *, uint16_t, int> formats[] = {
+			{"s24", bench::wave_pcm, 24}, {"s32", bench::wave_pcm, 32}, {"f32", bench::wave_float, 32}, {"f64", bench::wave_float, 64},
+		};
+		std::printf("%-24s %10s\n", "voice", "native");
+		for(auto &[format, tag, bits] : formats)
+		{
+			std::string name = std::string("wav-") + format;
+			std::string filename = dir + "/" + name + ".wav";
+			if(!bench::write_wave(filename, tag, bits, options.stereo ? 2 : 1, options.rate, options.rate / 2))
+			{
+				std::cerr << "cannot write " << filename << "\n";
+				return 1;
+			}
+			bool same = check_native(filename);
+			std::printf("%-24s %10s\n", name.c_str(), same ? "ok" : "FAILED");
+			if(!same)
+				++failed;
+		}
+		return failed ? 1 : 0;
+	}
+	std::vector<std::string> wave_all;
+	std::vector<VoiceKind> kinds;
+	for(int rate : {11025, 22050, 44100, 48000})
+	{
+		for(int channels : {1, 2})
+		{
+			std::string name = "wav-" + std::to_string(rate) + (channels == 2 ? "-stereo" : "-mono");
+			std::string filename = dir + "/" + name + ".wav";
+			if(!bench::write_wave(filename, bench::wave_pcm, 16, channels, rate, rate * 2))
+			{
+				std::cerr << "cannot write " << filename << "\n";
+				return 1;
+			}
+			wave_all.push_back(filename);
+			kinds.push_back(sources_kind(name, {filename}));
+		}
+	}
+	kinds.push_back(sources_kind("wav-mixed", wave_all));
+	{
+		std::string filename = dir + "/qoa-44100-stereo.qoa";
+		if(!bench::write_qoa(filename, 2, 44100, 44100 * 2))
+		{
+			std::cerr << "cannot write " << filename << "\n";
+			return 1;
+		}
+		kinds.push_back(sources_kind("qoa-44100-stereo", {filename}));
+	}
+
+	if(options.rt_check)
+	{
+		if(!rt_check::enabled())
+		{
+			std::cerr << "majimix is not built with MAJIMIX_RT_CHECK\n";
+			return 2;
+		}
+		// every WAVE format and QOA, in each storage mode
+		kinds.clear();
+		SourceOptions native;
+		native.pcm_native = true;
+		SourceOptions mapped;
+		mapped.wave_mapped = true;
+		SourceOptions streamed;
+		streamed.wave_streamed = true;
+		SourceOptions unshared;
+		unshared.shared_data = false;
+		const std::pair<const char *, SourceOptions> modes[] = {
+			{"", {}}, {"-native", native}, {"-mapped", mapped}, {"-streamed", streamed}, {"-unshared", unshared},
+		};
+		const std::tuple<const char *, uint16_t, int> formats[] = {
+			{"u8",   bench::wave_pcm,    8}, {"s16", bench::wave_pcm,   16}, {"s24", bench::wave_pcm, 24},
+			{"s32",  bench::wave_pcm,   32}, {"f32", bench::wave_float, 32}, {"f64", bench::wave_float, 64},
+			{"alaw", bench::wave_alaw,   8}, {"ulaw", bench::wave_ulaw,   8}, {"ima", bench::wave_ima, 4},
+			{"ms",   bench::wave_ms,     4},
+		};
+		std::vector<std::string> bank_waves;
+		for(auto &[format, tag, bits] : formats)
+		{
+			for(int channels : {1, 2})
+			{
+				std::string name = std::string("wav-") + format + (channels == 2 ? "-stereo" : "-mono");
+				std::string filename = dir + "/" + name + ".wav";
+				if(!bench::write_wave(filename, tag, bits, channels, 22050, 22050 / 2))
+				{
+					std::cerr << "cannot write " << filename << "\n";
+					return 1;
+				}
+				for(auto &[mode, source_options] : modes)
+					kinds.push_back(sources_kind(name + mode, {filename}, source_options));
+				if(channels == 2 && ((tag == bench::wave_pcm && bits <= 16) || (tag == bench::wave_float && bits == 32)))
+					bank_waves.push_back(filename);
+			}
+		}
+		for(int channels : {1, 2})
+		{
+			std::string name = std::string("qoa") + (channels == 2 ? "-stereo" : "-mono");
+			std::string filename = dir + "/" + name + ".qoa";
+			if(!bench::write_qoa(filename, channels, 22050, 22050 / 2))
+			{
+				std::cerr << "cannot write " << filename << "\n";
+				return 1;
+			}
+			for(auto &[mode, source_options] : modes)
+				kinds.push_back(sources_kind(name + mode, {filename}, source_options));
+		}
+
+		// the PCM assets and the Vorbis file played from a bank
+		{
+			std::string filename = dir + "/assets.bank";
+			if(!write_bank(filename, bank_waves, options.ogg))
+			{
+				std::cerr << "cannot write " << filename << "\n";
+				return 1;
+			}
+			for(auto &[mode, source_options] : modes)
+				kinds.push_back(bank_kind(std::string("bank") + mode, filename, source_options));
+		}
+
+		// the Vorbis file in each of its modes
+		if(!options.ogg.empty())
+		{
+			SourceOptions in_memory;
+			in_memory.vorbis_in_memory = true;
+			SourceOptions decoders;
+			decoders.vorbis_decoders = 4;
+			SourceOptions decoded;
+			decoded.vorbis_decode_max_ms = std::numeric_limits<int>::max();
+			SourceOptions loop_head;
+			loop_head.vorbis_loop_head_ms = 250;
+			loop_head.vorbis_seek_index = true;
+			const std::pair<const char *, SourceOptions> vorbis_modes[] = {
+				{"vorbis", {}}, {"vorbis-memory", in_memory}, {"vorbis-decoders", decoders}, {"vorbis-pcm", decoded},
+				{"vorbis-loop-head", loop_head}, {"vorbis-unshared", unshared},
+			};
+			for(auto &[name, source_options] : vorbis_modes)
+				kinds.push_back(sources_kind(name, {options.ogg}, source_options));
+		}
+
+		// KSS lines of a generated file
+		if(options.kss.empty())
+		{
+			options.kss = dir + "/tone.kss";
+			if(!bench::write_kss(options.kss))
+			{
+				std::cerr << "cannot write " << options.kss << "\n";
+				return 1;
+			}
+		}
+	}
+	else if(!options.ogg.empty())
+	{
+		kinds.push_back(sources_kind("vorbis", {options.ogg}));
+		// the same file decoded to PCM when added
+		SourceOptions decoded;
+		decoded.vorbis_decode_max_ms = std::numeric_limits<int>::max();
+		kinds.push_back(sources_kind("vorbis-pcm", {options.ogg}, decoded));
+	}
+
+	if(!options.kss.empty())
+	{
+		const std::string kss = options.kss;
+		const int track = options.track;
+		kinds.push_back({"kss-lines", [kss, track](MajimixOffline &mixer, int n) {
+			if(!n)
+				return true;
+			int h = mixer.add_source_kss(kss, n, 500);
+			if(h <= 0)
+				return false;
+			for(int i = 0; i < n; ++i)
+				if(!mixer.play_kss_track(h, track, false, false, false))
+					return false;
+			return true;
+		}});
+	}
+
+	if(options.rt_check)
+		return check_real_time(kinds, 4) ? 1 : 0;
+
+	std::printf("format %d Hz %d bits %s - block %d frames (budget %.1f us) - p%.1f of %d blocks\n",
+	            options.rate, options.bits, options.stereo ? "stereo" : "mono",
+	            options.block, 1e6 * options.block / options.rate, options.percentile, options.measure);
+	std::printf("%-24s %9s %8s %12s %10s\n", "voice", "max", "rtf", "us/voice", "%budget");
+	for(auto &kind : kinds)
+		stress(kind);
+
+	return 0;
+}
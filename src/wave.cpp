@@ -29,6 +29,8 @@
 
 
 #include "wave.hpp"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace majimix::wave {
@@ -74,6 +76,8 @@ static bool read_fmt(std::ifstream &is, uint32_t chunck_size, fmt_base &fmt)
 			fmt.wValidBitsPerSample = 0;
 			fmt.dwChannelMask = 0;
 			fmt.SubFormat[0] = '\0';
+			fmt.wSamplesPerBlock = 0;
+			fmt.coefficients.clear();
 			if (!little_endian)
 			{
 				fmt.wFormatTag = reverse_nibbles(fmt.wFormatTag);
@@ -94,6 +98,27 @@ static bool read_fmt(std::ifstream &is, uint32_t chunck_size, fmt_base &fmt)
 
 				if (fmt.cbSize == 0)
 					return true;
+				// ADPCM : samples per block, then the MS ADPCM coefficients
+				if ((fmt.wFormatTag == 0x0002 || fmt.wFormatTag == 0x0011) && fmt.cbSize >= 2 && chunck_size >= 18u + fmt.cbSize)
+				{
+					std::vector<char> extension(fmt.cbSize);
+					if (!is.read(extension.data(), fmt.cbSize))
+						return false;
+					auto value = [&extension](size_t offset) {
+						uint16_t v;
+						std::memcpy(&v, extension.data() + offset, sizeof v);
+						return little_endian ? v : reverse_nibbles(v);
+					};
+					fmt.wSamplesPerBlock = value(0);
+					if (fmt.wFormatTag == 0x0002 && fmt.cbSize >= 4)
+					{
+						size_t count = std::min<size_t>(value(2), (fmt.cbSize - 4) / 4);
+						for (size_t i = 0; i < count * 2; ++i)
+							fmt.coefficients.push_back(static_cast<int16_t>(value(4 + i * 2)));
+					}
+					is.seekg(chunck_size - 18 - fmt.cbSize, std::ios_base::cur);
+					return true;
+				}
 				if (fmt.cbSize == 22)
 				{
 					if (is.read(reinterpret_cast<char *>(&fmt.wValidBitsPerSample), sizeof fmt.wValidBitsPerSample) && is.read(reinterpret_cast<char *>(&fmt.dwChannelMask), sizeof fmt.dwChannelMask) && is.read(reinterpret_cast<char *>(&fmt.SubFormat), sizeof fmt.SubFormat))
@@ -112,23 +137,70 @@ static bool read_fmt(std::ifstream &is, uint32_t chunck_size, fmt_base &fmt)
 	return false;
 }
 
-static bool read_RIFF(std::ifstream &is, pcm_data &audio)
+static bool read_smpl(std::ifstream &is, uint64_t chunck_size, pcm_data &audio)
+{
+	// sampler : 36 bytes header (loop count at 28) then 24 bytes per loop
+	// (id, type, start, end - included -, fraction, play count)
+	std::vector<char> smpl(chunck_size);
+	if (!is.read(smpl.data(), chunck_size))
+		return false;
+	auto value = [&smpl](size_t offset) {
+		uint32_t v;
+		std::memcpy(&v, smpl.data() + offset, sizeof v);
+		return little_endian ? v : reverse_nibbles(v);
+	};
+	if (chunck_size >= 60 && value(28) > 0 && value(48) >= value(44))
+	{
+		audio.loop_start = value(44);
+		audio.loop_end = value(48) + 1;
+	}
+	return true;
+}
+
+static bool read_data_chunck(std::ifstream &is, uint64_t chunck_size, pcm_data &audio, bool read_data)
+{
+	audio.data_size = chunck_size;
+	audio.data_offset = static_cast<uint64_t>(is.tellg());
+	// loaded in memory : the size of the PCM sources is limited (RF64 and W64 files can be larger),
+	// a larger data chunk is not read (the file can be streamed)
+	if (!read_data || chunck_size > static_cast<uint64_t>(INT32_MAX))
+		return static_cast<bool>(is.seekg(chunck_size, std::ios_base::cur));
+	audio.data.assign(chunck_size, 0);
+	return static_cast<bool>(is.read(&audio.data[0], chunck_size));
+}
+
+static void report_error(bool data_loaded, bool fmt_loaded)
+{
+	if (data_loaded && fmt_loaded)
+		std::cerr << "error while reading a chunk [data and format are loaded]" << std::endl;
+	else if (fmt_loaded)
+		std::cerr << "error while reading data [data not loaded]" << std::endl;
+	else if (data_loaded)
+		std::cerr << "error while reading data [format not loaded]" << std::endl;
+	else
+		std::cerr << "error while reading data [format and data not loaded]" << std::endl;
+}
+
+/* RIFF and RF64 (sizes over 4 GB in the ds64 chunk) */
+static bool read_RIFF(std::ifstream &is, pcm_data &audio, bool read_data)
 {
 	std::string chunck;
 	uint32_t chunck_size;
 	bool err = false;
 	if (read_chunck(is, chunck, chunck_size))
 	{
-		if (chunck == "RIFF" && chunck_size > 4)
+		if ((chunck == "RIFF" || chunck == "RF64") && chunck_size > 4)
 		{
+			bool rf64 = chunck == "RF64";
 			// std::cout << " cur pos " << is.tellg() << " - sz "<<chunck_size<< std::endl;
 			if (is.read(&chunck[0], 4) && chunck == "WAVE")
 			{
-				uint32_t position_max = 8 + chunck_size;
+				uint64_t position_max = 8 + static_cast<uint64_t>(chunck_size);
+				uint64_t ds64_data_size = 0;
 				bool done = false;
 				bool data_loaded = false;
 				bool fmt_loaded = false;
-				while (!done && (position_max - is.tellg()) > 8 && !err)
+				while (!done && position_max > static_cast<uint64_t>(is.tellg()) + 8 && !err)
 				{
 					if (read_chunck(is, chunck, chunck_size))
 					{
@@ -139,6 +211,20 @@ static bool read_RIFF(std::ifstream &is, pcm_data &audio)
 							else
 								err = true;
 						}
+						else if (chunck == "ds64" && rf64 && chunck_size >= 16)
+						{
+							// 64 bits sizes of the RIFF and data chunks
+							uint64_t riff_size;
+							if (!is.read(reinterpret_cast<char *>(&riff_size), sizeof riff_size) || !is.read(reinterpret_cast<char *>(&ds64_data_size), sizeof ds64_data_size))
+								break;
+							if (!little_endian)
+							{
+								riff_size = reverse_nibbles(riff_size);
+								ds64_data_size = reverse_nibbles(ds64_data_size);
+							}
+							position_max = 8 + riff_size;
+							is.seekg(chunck_size - 16 + chunck_size % 2, std::ios_base::cur);
+						}
 						else if (chunck == "fact")
 						{
 							// std::cout << "read fact" << std::endl;
@@ -147,17 +233,24 @@ static bool read_RIFF(std::ifstream &is, pcm_data &audio)
 							if (!little_endian)
 								audio.fmt.dwSampleLength = reverse_nibbles(audio.fmt.dwSampleLength);
 						}
+						else if (chunck == "smpl")
+						{
+							if (!read_smpl(is, chunck_size, audio))
+								break;
+							if (chunck_size % 2)
+								is.get();
+						}
 						else if (chunck == "data")
 						{
-							audio.data.assign(chunck_size, 0);
-							if (!is.read(&audio.data[0], chunck_size))
+							uint64_t data_size = rf64 && chunck_size == 0xFFFFFFFF ? ds64_data_size : chunck_size;
+							if (!read_data_chunck(is, data_size, audio, read_data))
 								err = true;
 
 							if (!err)
 							{
 								data_loaded = true;
 								// padding byte if odd
-								if (chunck_size % 2)
+								if (data_size % 2)
 									is.get();
 							}
 						}
@@ -177,16 +270,7 @@ static bool read_RIFF(std::ifstream &is, pcm_data &audio)
 					err = true;
 
 				if (err)
-				{
-					if (data_loaded && fmt_loaded)
-						std::cerr << "error while reading a chunk [data and format are loaded]" << std::endl;
-					else if (fmt_loaded)
-						std::cerr << "error while reading data [data not loaded]" << std::endl;
-					else if (fmt_loaded)
-						std::cerr << "error while reading data [format not loaded]" << std::endl;
-					else
-						std::cerr << "error while reading data [format and data not loaded]" << std::endl;
-				}
+					report_error(data_loaded, fmt_loaded);
 			}
 			else
 			{
@@ -212,6 +296,96 @@ static bool read_RIFF(std::ifstream &is, pcm_data &audio)
 	return !err;
 }
 
+/*
+ * Sony Wave64 : the chunks are identified by GUIDs, their sizes are 64 bits (header included)
+ * and they are aligned on 8 bytes.
+ * The GUIDs of the WAVE chunks start with their RIFF name and end with the same 12 bytes.
+ */
+static const unsigned char w64_riff_guid[16] = {'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00};
+static const unsigned char w64_guid_suffix[12] = {0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+
+static bool read_w64_chunck(std::ifstream &is, std::string &chunck, uint64_t &chunck_size)
+{
+	unsigned char guid[16];
+	if (is.read(reinterpret_cast<char *>(guid), sizeof guid) && is.read(reinterpret_cast<char *>(&chunck_size), sizeof chunck_size))
+	{
+		if (!little_endian)
+			chunck_size = reverse_nibbles(chunck_size);
+		if (chunck_size < 24)
+			return false;
+		// chunck_size : size of the chunk content
+		chunck_size -= 24;
+		if (std::memcmp(guid, w64_riff_guid, sizeof guid) == 0)
+			chunck = "riff";
+		else if (std::memcmp(guid + 4, w64_guid_suffix, sizeof w64_guid_suffix) == 0)
+			chunck.assign(reinterpret_cast<char *>(guid), 4);
+		else
+			chunck = "????";
+		return true;
+	}
+	return false;
+}
+
+static bool read_W64(std::ifstream &is, pcm_data &audio, bool read_data)
+{
+	std::string chunck;
+	uint64_t chunck_size;
+	unsigned char guid[16];
+	if (!read_w64_chunck(is, chunck, chunck_size) || chunck != "riff" || !is.read(reinterpret_cast<char *>(guid), sizeof guid) || std::memcmp(guid, "wave", 4) || std::memcmp(guid + 4, w64_guid_suffix, sizeof w64_guid_suffix))
+	{
+		std::cerr << "invalid Wave64 header" << std::endl;
+		return false;
+	}
+
+	uint64_t position_max = 24 + chunck_size;
+	bool err = false;
+	bool data_loaded = false;
+	bool fmt_loaded = false;
+	while (position_max > static_cast<uint64_t>(is.tellg()) + 24 && !err)
+	{
+		if (!read_w64_chunck(is, chunck, chunck_size))
+		{
+			err = true;
+			break;
+		}
+		uint64_t next = static_cast<uint64_t>(is.tellg()) + ((chunck_size + 7) & ~uint64_t(7));
+		if (chunck == "fmt ")
+		{
+			if (read_fmt(is, static_cast<uint32_t>(chunck_size), audio.fmt))
+				fmt_loaded = true;
+			else
+				err = true;
+		}
+		else if (chunck == "fact" && chunck_size >= 4)
+		{
+			if (!is.read(reinterpret_cast<char *>(&audio.fmt.dwSampleLength), sizeof audio.fmt.dwSampleLength))
+				break;
+			if (!little_endian)
+				audio.fmt.dwSampleLength = reverse_nibbles(audio.fmt.dwSampleLength);
+		}
+		else if (chunck == "smpl")
+		{
+			if (!read_smpl(is, chunck_size, audio))
+				break;
+		}
+		else if (chunck == "data")
+		{
+			if (read_data_chunck(is, chunck_size, audio, read_data))
+				data_loaded = true;
+			else
+				err = true;
+		}
+		// 8 bytes alignment
+		is.seekg(static_cast<std::streamoff>(next));
+	}
+
+	if (!data_loaded || !fmt_loaded)
+		err = true;
+	if (err)
+		report_error(data_loaded, fmt_loaded);
+	return !err;
+}
+
 /* test if the file seems to be a wave file */
 bool test_wave(const std::string &file)
 {
@@ -222,19 +396,20 @@ bool test_wave(const std::string &file)
 		// needed to keep white spaces
 		wstream.unsetf(std::ios_base::skipws);
 
-		// ensure ifstream objects can throw exceptions:
-		wstream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-		std::string chunck;
-		uint32_t chunck_size;
-		if (read_chunck(wstream, chunck, chunck_size))
-			if (chunck == "RIFF" && chunck_size > 4)
-				done = wstream.read(&chunck[0], 4) && chunck == "WAVE";
+		char header[40];
+		if (wstream.read(header, sizeof header))
+		{
+			// RIFF / RF64 : "WAVE" at 8 - Wave64 : riff GUID, size, wave GUID
+			if ((std::memcmp(header, "RIFF", 4) == 0 || std::memcmp(header, "RF64", 4) == 0))
+				done = std::memcmp(header + 8, "WAVE", 4) == 0;
+			else if (std::memcmp(header, w64_riff_guid, sizeof w64_riff_guid) == 0)
+				done = std::memcmp(header + 24, "wave", 4) == 0 && std::memcmp(header + 28, w64_guid_suffix, sizeof w64_guid_suffix) == 0;
+		}
 	}
 	return done;
 }
 
-bool load_wave(const std::string &file, pcm_data &audio)
+bool load_wave(const std::string &file, pcm_data &audio, bool read_data)
 {
 	// std::cout << "loading "<<file << std::endl;
 	bool done = false;
@@ -244,12 +419,18 @@ bool load_wave(const std::string &file, pcm_data &audio)
 		// needed to keep white spaces
 		wstream.unsetf(std::ios_base::skipws);
 
+		// Wave64 : starts with the riff GUID
+		char id[4] = {};
+		wstream.read(id, sizeof id);
+		wstream.seekg(0);
+		bool w64 = std::memcmp(id, w64_riff_guid, sizeof id) == 0;
+
 		// ensure ifstream objects can throw exceptions:
 		wstream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
-		if (read_RIFF(wstream, audio))
+		if (w64 ? read_W64(wstream, audio, read_data) : read_RIFF(wstream, audio, read_data))
 		{
-			audio.sample_size = audio.data.size() / audio.fmt.nBlockAlign;
+			audio.sample_size = audio.data_size / audio.fmt.nBlockAlign;
 			done = true;
 		}
 	}
@@ -262,6 +443,8 @@ std::ostream &operator<<(std::ostream &out, const WAVE_FORMAT &f)
 				 : f == WAVE_FORMAT::WAVE_FORMAT_IEEE_FLOAT ? "WAVE_FORMAT_IEEE_FLOAT" 
 				 : f == WAVE_FORMAT::WAVE_FORMAT_ALAW       ? "WAVE_FORMAT_ALAW" 
                  : f == WAVE_FORMAT::WAVE_FORMAT_MULAW		? "WAVE_FORMAT_MULAW" 
+                 : f == WAVE_FORMAT::WAVE_FORMAT_ADPCM		? "WAVE_FORMAT_ADPCM" 
+                 : f == WAVE_FORMAT::WAVE_FORMAT_IMA_ADPCM	? "WAVE_FORMAT_IMA_ADPCM" 
 			     : f == WAVE_FORMAT::WAVE_FORMAT_EXTENSIBLE	? "WAVE_FORMAT_EXTENSIBLE" 
 								                            : "WAVE_FORMAT_UNKNOW");
 }
@@ -278,6 +461,10 @@ WAVE_FORMAT get_wave_format(unsigned int code)
 		return WAVE_FORMAT::WAVE_FORMAT_ALAW;
 	case 0x0007:
 		return WAVE_FORMAT::WAVE_FORMAT_MULAW;
+	case 0x0002:
+		return WAVE_FORMAT::WAVE_FORMAT_ADPCM;
+	case 0x0011:
+		return WAVE_FORMAT::WAVE_FORMAT_IMA_ADPCM;
 	case 0xFFFE:
 		return WAVE_FORMAT::WAVE_FORMAT_EXTENSIBLE;
 	default:
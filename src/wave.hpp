@@ -57,6 +57,10 @@ struct fmt_base
 	uint32_t dwChannelMask = 0;		  // Speaker position mask
 	unsigned char SubFormat[16];	  // GUID, including the data format code
 
+	// -- ADPCM extension
+	uint16_t wSamplesPerBlock = 0;     // Samples (per channel) in a block
+	std::vector<int16_t> coefficients; // MS ADPCM : predictor coefficients (pairs)
+
 	// fact
 	uint32_t dwSampleLength = 0; // Number of samples (per channel)
 };
@@ -67,14 +71,20 @@ struct pcm_data
 {
 	fmt_base fmt;
 	std::vector<char> data;
-	uint32_t sample_size; // total size : number of sample in data
+	uint64_t data_size = 0;		  // data chunk size (bytes)
+	uint64_t data_offset = 0;	  // data chunk position in the file
+	uint64_t sample_size; // total size : number of sample in data
 	int out_bits = 0;			  // out bits per sample : same as fmt.wBitsPerSample except for μ-law and a-law formats : fmt.wBitsPerSample = 8 and out_bits = 16
 	uint16_t out_nBlockAlign = 0; // taille d'un sample en sortie (= nBlockAlign sauf pour Alaw et μ-law ou on a une entree 8bits et un sortie 16 bits => out_nBlockAlign = 2 x nBlockAlign)
+	uint32_t loop_start = 0;	  // smpl chunk, first loop (samples) - loop_end excluded, 0 : no loop
+	uint32_t loop_end = 0;
 };
 
-/* test if the file seems to be a wave file */
+/* test if the file seems to be a wave file (RIFF, RF64 or Wave64) */
 bool test_wave(const std::string &file);
-bool load_wave(const std::string &file, pcm_data &audio);
+/* read_data = false : only the data chunk position and size are read (the file is mapped by the caller)
+ * - a data chunk over 2 GB is never read (data stays empty) */
+bool load_wave(const std::string &file, pcm_data &audio, bool read_data = true);
 
 /*
  * wave format :  http://www-mmsp.ece.mcgill.ca/Documents/AudioFormats/WAVE/WAVE.html
@@ -94,6 +104,8 @@ enum class WAVE_FORMAT
 	WAVE_FORMAT_IEEE_FLOAT,
 	WAVE_FORMAT_ALAW,
 	WAVE_FORMAT_MULAW,
+	WAVE_FORMAT_ADPCM,
+	WAVE_FORMAT_IMA_ADPCM,
 	WAVE_FORMAT_EXTENSIBLE,
 	WAVE_FORMAT_UNKNOW,
 };